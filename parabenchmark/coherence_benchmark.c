@@ -0,0 +1,641 @@
+/*
+ * coherence_benchmark.c
+ *
+ * Cache coherence costs: false sharing of counters, which are a configurable
+ * number of bytes apart, and the core-to-core latency of moving a cache
+ * line between two pinned threads.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "coherence_benchmark.h"
+#include "pthread_functions.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+#include "system_info.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#define __USE_GNU
+#include <sched.h>
+#include <pthread.h>
+
+extern config_t config;
+
+#define COHERENCE_ALIGNMENT 4096
+
+// distance of the per thread targets of the atomics benchmark
+#define COHERENCE_PADDING 128
+
+/**
+ * spinning threads yield the processor after this many polls, so that
+ * oversubscribed runs still make progress
+ */
+#define COHERENCE_SPIN_YIELD 1024
+
+/**
+ * the threads publish their progress after this many operations
+ */
+#define COHERENCE_CHUNK 1024
+
+typedef enum {
+	COHERENCE_PLAIN,	// load, add, store
+	COHERENCE_ATOMIC,	// lock add
+	COHERENCE_XADD,		// lock xadd
+	COHERENCE_CMPXCHG,	// lock cmpxchg loop, retried on failure
+	COHERENCE_XCHG,		// xchg (implicitly locked)
+	COHERENCE_RELAXED,	// C11 atomic_fetch_add, memory_order_relaxed
+	COHERENCE_SEQ_CST	// C11 atomic_fetch_add, memory_order_seq_cst
+} coherence_op_t;
+
+struct {
+	char *name;
+	coherence_op_t op;
+} coherence_ops[] = {
+		{"plain", COHERENCE_PLAIN},
+		{"atomic", COHERENCE_ATOMIC},
+		{"xadd", COHERENCE_XADD},
+		{"cmpxchg", COHERENCE_CMPXCHG},
+		{"xchg", COHERENCE_XCHG},
+		{"relaxed", COHERENCE_RELAXED},
+		{"seqcst", COHERENCE_SEQ_CST},
+		{NULL, COHERENCE_PLAIN}
+};
+
+/**
+ * operation of an option token, -1 if unknown
+ */
+int coherence_op(char *name) {
+	int i;
+	for(i=0; coherence_ops[i].name != NULL; i++) {
+		if(strcmp(coherence_ops[i].name, name) == 0) return coherence_ops[i].op;
+	}
+	return -1;
+}
+
+/**
+ * shared by the threads of one repetition
+ */
+typedef struct {
+	unsigned num_threads;
+	volatile unsigned started __attribute__((aligned(COHERENCE_PADDING)));
+	volatile int finished __attribute__((aligned(COHERENCE_PADDING)));
+} coherence_control_t;
+
+/**
+ * padded, as the progress is written while the counters are updated
+ */
+typedef struct {
+	volatile unsigned_huge *counter;
+	unsigned_huge iterations;
+	coherence_op_t op;
+	coherence_control_t *control;
+	volatile unsigned_huge done;	// operations so far
+	unsigned_huge window;			// operations when the first thread finished
+} __attribute__((aligned(COHERENCE_PADDING))) coherence_thread_data_t;
+
+static inline void coherence_pause(unsigned *spins) {
+	if(++*spins % COHERENCE_SPIN_YIELD == 0) sched_yield();
+	else __asm__ __volatile__ ("pause" ::: "memory");
+}
+
+#define COHERENCE_LOOP(body, clobber...) \
+	asm volatile ( \
+		"1:" \
+		body \
+		"dec %[i];" \
+		"jnz 1b;" \
+		: [i] "+r" (i) \
+		: [c] "r" (counter) \
+		: "cc", "memory", ## clobber \
+	)
+
+/**
+ * update the counter of the thread, every thread measures its own time.
+ * The threads wait for each other before they start, so that they update
+ * their counters at the same time and not as they are dispatched. The
+ * first thread which is done takes the progress of all threads, which is
+ * the number of operations of every thread in a common window
+ */
+void *coherence_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	coherence_thread_data_t *data = (coherence_thread_data_t*) arg->data;
+	coherence_control_t *control = data->control;
+	volatile unsigned_huge *counter = data->counter;
+	_Atomic unsigned_huge *atomic_counter = (_Atomic unsigned_huge *) counter;
+	unsigned_huge i, left = data->iterations;
+	unsigned spins = 0;
+	__sync_add_and_fetch(&control->started, 1);
+	while(control->started < control->num_threads) coherence_pause(&spins);
+	double tmp;
+	tick2(MODE_START, &tmp);
+	while(left > 0) {
+		i = left < COHERENCE_CHUNK ? left : COHERENCE_CHUNK;
+		left -= i;
+		switch(data->op) {
+		case COHERENCE_PLAIN:
+			COHERENCE_LOOP("incq (%[c]);");
+			break;
+		case COHERENCE_ATOMIC:
+			COHERENCE_LOOP("lock incq (%[c]);");
+			break;
+		case COHERENCE_XADD:
+			COHERENCE_LOOP("mov $1, %%rax;" "lock xadd %%rax, (%[c]);", "rax");
+			break;
+		case COHERENCE_CMPXCHG:
+			COHERENCE_LOOP(
+					"mov (%[c]), %%rax;"
+					"2:"
+					"lea 1(%%rax), %%rdx;"
+					"lock cmpxchg %%rdx, (%[c]);"
+					"jnz 2b;", "rax", "rdx");
+			break;
+		case COHERENCE_XCHG:
+			COHERENCE_LOOP("mov %[i], %%rax;" "xchg %%rax, (%[c]);", "rax");
+			break;
+		case COHERENCE_RELAXED:
+			for(; i>0; i--) atomic_fetch_add_explicit(atomic_counter, 1, memory_order_relaxed);
+			break;
+		case COHERENCE_SEQ_CST:
+			for(; i>0; i--) atomic_fetch_add_explicit(atomic_counter, 1, memory_order_seq_cst);
+			break;
+		}
+		data->done = data->iterations - left;
+	}
+	arg->time = tick2(MODE_END, &tmp);
+	if(__sync_bool_compare_and_swap(&control->finished, 0, 1)) {
+		unsigned t;
+		for(t=0; t<control->num_threads; t++) {
+			coherence_thread_data_t *other = (coherence_thread_data_t*) arg->allargs[t].data;
+			other->window = other->done;
+		}
+	}
+	return (void *)NULL;
+}
+
+/**
+ * 'num_threads' threads update 'iterations' times their counter, the
+ * counters are 'distance' bytes apart (0: all threads share one counter)
+ */
+void coherence_test(unsigned num_threads, unsigned_huge distance,
+		unsigned_huge iterations, coherence_op_t op) {
+	if(num_threads == 0 || iterations == 0) return;
+	if(distance != 0 && distance < sizeof(unsigned_huge)) {
+		_printf("WARNING: counter distance %Lu smaller than a counter\n", distance);
+		return;
+	}
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL) {
+		_printf("Cannot allocate enough space for threads\n");
+		return;
+	}
+	void *buffer = NULL;
+	if(posix_memalign(&buffer, COHERENCE_ALIGNMENT, num_threads*distance + COHERENCE_ALIGNMENT) != 0) {
+		_printf("WARNING: couldn't allocate counters for coherence benchmark\n");
+		return;
+	}
+	memset(buffer, 0, num_threads*distance + COHERENCE_ALIGNMENT);
+
+	coherence_control_t control;
+	control.num_threads = num_threads;
+	coherence_thread_data_t data[num_threads];
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		data[i].counter = (volatile unsigned_huge *)((char *)buffer + i*distance);
+		data[i].iterations = iterations;
+		data[i].op = op;
+		data[i].control = &control;
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &coherence_loop;
+		args[i].data = &data[i];
+	}
+
+	unsigned_huge repetitions = config.repetitions.number;
+	if(config.repetitions.time_guide_value != 0) repetitions = 10000;
+	double *time_single = (double*)malloc((repetitions+1)*sizeof(double));
+	double *time_slowest = (double*)malloc((repetitions+1)*sizeof(double));
+	double *time_fastest = (double*)malloc((repetitions+1)*sizeof(double));
+	double *fairness = (double*)malloc((repetitions+1)*sizeof(double));
+	statistic_t stat = STATISTIC_T_INIT;
+	int r;
+	for(r=-config.warmup; r<(int)repetitions; r++) {
+		control.started = 0;
+		control.finished = 0;
+		for(i=0; i<num_threads; i++) data[i].done = 0;
+		threads_prepare(args, num_threads);
+		threads_start(args, num_threads);
+		threads_join(args, num_threads);
+		if(r < 0) continue;
+
+		// mean, minimum and maximum time of the threads
+		double sum = 0, max = 0, min = args[0].time;
+		for(i=0; i<num_threads; i++) {
+			sum += args[i].time;
+			max = args[i].time > max ? args[i].time : max;
+			min = args[i].time < min ? args[i].time : min;
+		}
+		time_single[r] = sum / num_threads;
+		time_slowest[r] = max;
+		time_fastest[r] = min;
+
+		// fewest / most operations of the threads until the first one was done
+		unsigned_huge window_min = data[0].window, window_max = data[0].window;
+		for(i=1; i<num_threads; i++) {
+			window_min = data[i].window < window_min ? data[i].window : window_min;
+			window_max = data[i].window > window_max ? data[i].window : window_max;
+		}
+		fairness[r] = (double) window_min / window_max;
+		calculate_statistics_iterative(&stat, time_single[r]);
+
+		if(config.repetitions.time_guide_value != 0 && r >= config.repetitions.min) {
+			if(stat.mean * (r + 1) > config.repetitions.time_guide_value) {
+				repetitions = r+1;
+				break;
+			}
+		}
+	}
+	stat = middle_stat(time_single, repetitions);
+	statistic_t stat_slowest = middle_stat(time_slowest, repetitions);
+	statistic_t stat_fastest = middle_stat(time_fastest, repetitions);
+	statistic_t stat_fairness = middle_stat(fairness, repetitions);
+	free(time_single);
+	free(time_slowest);
+	free(time_fastest);
+	free(fairness);
+	free(buffer);
+
+	double per_thread = iterations / stat.mean / 1e6;
+	print_table_cell("%{threads}5u, ", num_threads);
+	print_table_cell("%{distance}8Lu, ", distance);
+	print_table_cell("%{iterations}12Lu, ", iterations);
+	print_table_cell("%{repetitions}6Lu, ", repetitions);
+	print_table_cell("%{time}" PRECISSION "f, ", stat.mean);
+	print_table_cell("%{time deviation}" PRECISSION "f, ", stat.deviation);
+	print_table_cell("%{ns per op}" PRECISSION "f, ", stat.mean / iterations * 1e9);
+	print_table_cell("%{mega ops per second per thread}" PRECISSION "f, ", per_thread);
+	print_table_cell("%{slowest thread}" PRECISSION "f, ", iterations / stat_slowest.mean / 1e6);
+	print_table_cell("%{fastest thread}" PRECISSION "f, ", iterations / stat_fastest.mean / 1e6);
+	print_table_cell("%{fairness}6.3f, ", stat_fairness.mean);
+	print_table_cell("%{total}" PRECISSION "f, ", per_thread * num_threads);
+	print_table_line();
+}
+
+void start_false_sharing_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("false sharing benchmark\n");
+	_printf("distance: bytes between the counters of the threads (0: one shared counter)\n");
+	_printf("throughput in mega increments per second\n");
+	_printf("fairness = fewest / most operations of a thread until the first thread is done\n");
+	_printf("###############\n");
+
+	if(option == NULL) option = "plain,0,8,64,128,256";
+	if(strcmp(option, "all") == 0) option = "plain,0,8,64,128,256,atomic,0,8,64,128,256";
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	get_thread_array(config.threads->end);
+
+	coherence_op_t op = COHERENCE_PLAIN;
+	unsigned_huge distance = 0;
+	// operation or distance for the following iterations
+	int set_distance_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+		char *token = options[num_option];
+		if(strcmp(token, "plain") == 0 || strcmp(token, "atomic") == 0) {
+			op = strcmp(token, "plain") == 0 ? COHERENCE_PLAIN : COHERENCE_ATOMIC;
+			print_table_set_additional_info("operation", token);
+			return NESTED_FOR_CONT;
+		}
+		char *end;
+		distance = strtoull(token, &end, 0);
+		if(*token == '\0' || *end != '\0') {
+			_printf("WARNING: unknown option for false sharing benchmark: %s\n", token);
+			return NESTED_FOR_CONT;
+		}
+		print_header();
+		return 0;
+	}
+	print_table_set_additional_info("operation", "plain");
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
+		unsigned_huge iterations; get_iteration_value("iteration", level, vec, &iterations);
+		coherence_test(num_threads, distance, iterations, op);
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_distance_fn;
+
+	for_loop_t iteration_loop = FOR_LOOP_T_INIT;
+	iteration_loop.var.name = "iteration";
+	iteration_loop.var.range = config.range;
+	iteration_loop.step_fn = &step_range;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+
+	option_loop.next = &iteration_loop;
+	iteration_loop.next = &thread_loop;
+
+	nested_for_loop(&option_loop, fn);
+}
+
+void start_atomics_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("atomics benchmark\n");
+	_printf("target: one shared counter, or padded counters %d bytes apart\n", COHERENCE_PADDING);
+	_printf("throughput in mega operations per second\n");
+	_printf("fairness = fewest / most operations of a thread until the first thread is done\n");
+	_printf("###############\n");
+
+	if(option == NULL) option = "shared,xadd,cmpxchg,xchg,relaxed,seqcst,"
+			"padded,xadd,cmpxchg,xchg,relaxed,seqcst";
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	get_thread_array(config.threads->end);
+
+	coherence_op_t op = COHERENCE_XADD;
+	unsigned_huge distance = 0;
+	char *target = "shared";
+	char *additional_info = NULL;
+	// target for the following operations, or the operation
+	int set_op_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+		char *token = options[num_option];
+		if(strcmp(token, "shared") == 0 || strcmp(token, "padded") == 0) {
+			distance = strcmp(token, "shared") == 0 ? 0 : COHERENCE_PADDING;
+			target = token;
+			return NESTED_FOR_CONT;
+		}
+		int token_op = coherence_op(token);
+		if(token_op < 0) {
+			_printf("WARNING: unknown option for atomics benchmark: %s\n", token);
+			return NESTED_FOR_CONT;
+		}
+		op = token_op;
+		free(additional_info);
+		additional_info = NULL;
+		strappend(&additional_info, token);
+		strappend(&additional_info, ", ");
+		strappend(&additional_info, target);
+		print_table_set_additional_info("operation, target", additional_info);
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
+		unsigned_huge iterations; get_iteration_value("iteration", level, vec, &iterations);
+		coherence_test(num_threads, distance, iterations, op);
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_op_fn;
+
+	for_loop_t iteration_loop = FOR_LOOP_T_INIT;
+	iteration_loop.var.name = "iteration";
+	iteration_loop.var.range = config.range;
+	iteration_loop.step_fn = &step_range;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+
+	option_loop.next = &iteration_loop;
+	iteration_loop.next = &thread_loop;
+
+	nested_for_loop(&option_loop, fn);
+	free(additional_info);
+}
+
+/**
+ * relation of two logical cpus in the topology of /proc/cpuinfo
+ */
+typedef enum {
+	PAIR_SMT,			// same physical core
+	PAIR_SOCKET,		// same physical package
+	PAIR_CROSS_SOCKET,
+	PAIR_TYPES
+} cpu_pair_t;
+
+const char *cpu_pair_name(cpu_pair_t type) {
+	switch(type) {
+	case PAIR_SMT: return "smt sibling";
+	case PAIR_SOCKET: return "same socket";
+	case PAIR_CROSS_SOCKET: return "cross socket";
+	default: break;
+	}
+	return "unknown";
+}
+
+cpu_pair_t cpu_pair_type(cpuinfo_t *a, cpuinfo_t *b) {
+	if(a->physical_id != b->physical_id) return PAIR_CROSS_SOCKET;
+	if(a->core_id != b->core_id) return PAIR_SOCKET;
+	return PAIR_SMT;
+}
+
+/**
+ * The initiator writes odd values to the flag and waits for the next even
+ * value from the responder, so the line moves twice per round trip
+ */
+typedef struct {
+	volatile unsigned_huge *flag;
+	volatile unsigned_huge *ready;
+	unsigned_huge round_trips;
+	int repetitions;		// including warmup
+	double *time;			// per repetition (initiator only)
+	bool initiator;
+} pingpong_data_t;
+
+void *pingpong_loop(void *ptr) {
+	pingpong_data_t *data = (pingpong_data_t *) ptr;
+	volatile unsigned_huge *flag = data->flag;
+	unsigned_huge n = data->round_trips;
+	unsigned_huge value = 0;
+	int r;
+	if(!data->initiator) {
+		__atomic_store_n(data->ready, 1, __ATOMIC_RELEASE);
+		unsigned_huge i, total = n * data->repetitions;
+		for(i=0; i<total; i++) {
+			value += 2;
+			while(__atomic_load_n(flag, __ATOMIC_ACQUIRE) != value - 1);
+			__atomic_store_n(flag, value, __ATOMIC_RELEASE);
+		}
+		return (void *)NULL;
+	}
+
+	while(__atomic_load_n(data->ready, __ATOMIC_ACQUIRE) == 0);
+	for(r=0; r<data->repetitions; r++) {
+		double tmp;
+		unsigned_huge i;
+		tick2(MODE_START, &tmp);
+		for(i=0; i<n; i++) {
+			__atomic_store_n(flag, value + 1, __ATOMIC_RELEASE);
+			value += 2;
+			while(__atomic_load_n(flag, __ATOMIC_ACQUIRE) != value);
+		}
+		data->time[r] = tick2(MODE_END, &tmp);
+	}
+	return (void *)NULL;
+}
+
+/**
+ * start a thread pinned to a processor
+ */
+int pingpong_create(pthread_t *thread, unsigned processor_id, pingpong_data_t *data) {
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	CPU_SET(processor_id, &mask);
+	pthread_attr_setaffinity_np(&attr, sizeof(mask), &mask);
+	int err = pthread_create(thread, &attr, &pingpong_loop, data);
+	pthread_attr_destroy(&attr);
+	return err;
+}
+
+/**
+ * One way latency in seconds of a cache line transfer from processor 'a'
+ * to processor 'b' and back, NAN on error
+ */
+double pingpong_test(unsigned a, unsigned b) {
+	unsigned_huge round_trips = config.steps.number;
+	int repetitions = config.repetitions.number;
+	int total = repetitions + config.warmup;
+
+	// flag and ready counter on separate cache lines
+	void *buffer = NULL;
+	if(posix_memalign(&buffer, COHERENCE_ALIGNMENT, 2*64) != 0) return NAN;
+	memset(buffer, 0, 2*64);
+	double time[total];
+	pingpong_data_t initiator = {(volatile unsigned_huge *)buffer,
+			(volatile unsigned_huge *)((char *)buffer + 64), round_trips, total, time, true};
+	pingpong_data_t responder = initiator;
+	responder.initiator = false;
+
+	pthread_t threads[2];
+	if(pingpong_create(&threads[1], b, &responder) != 0) {
+		free(buffer);
+		return NAN;
+	}
+	if(pingpong_create(&threads[0], a, &initiator) != 0) {
+		_printf("WARNING: couldn't start thread on processor %u\n", a);
+		// let the responder finish
+		unsigned_huge value = 0, i;
+		for(i=0; i<round_trips*total; i++) {
+			value += 2;
+			__atomic_store_n(initiator.flag, value - 1, __ATOMIC_RELEASE);
+			while(__atomic_load_n(initiator.flag, __ATOMIC_ACQUIRE) != value);
+		}
+		pthread_join(threads[1], NULL);
+		free(buffer);
+		return NAN;
+	}
+	pthread_join(threads[0], NULL);
+	pthread_join(threads[1], NULL);
+	free(buffer);
+
+	statistic_t stat = middle_stat(time + config.warmup, repetitions);
+	return stat.mean / (2 * round_trips);
+}
+
+void start_core_to_core_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("core to core benchmark\n");
+	_printf("one way latency in ns of a cache line between the processor of the row and of the column\n");
+	_printf("round trips per repetition: %Lu (steps option)\n", config.steps.number);
+	_printf("###############\n");
+
+	unsigned n = get_cpu_count();
+	if(n < 2) {
+		_printf("WARNING: core to core benchmark needs at least two processors\n");
+		return;
+	}
+	double latency[n][n];
+	unsigned i, j;
+	for(i=0; i<n; i++) {
+		for(j=0; j<n; j++) {
+			latency[i][j] = NAN;
+			if(i == j) continue;
+			latency[i][j] = pingpong_test(get_cpuinfo(i)->processor_id,
+					get_cpuinfo(j)->processor_id) * 1e9;
+		}
+	}
+
+	// latency matrix
+	print_header();
+	for(i=0; i<n; i++) {
+		print_table_cell("%{processor}5d, ", get_cpuinfo(i)->processor_id);
+		for(j=0; j<n; j++) {
+			char format[32];
+			sprintf(format, "%%{%d}8.1f, ", get_cpuinfo(j)->processor_id);
+			print_table_cell(format, latency[i][j]);
+		}
+		print_table_line();
+	}
+	_printf("\n");
+
+	// summary per topology relation
+	print_header();
+	int type;
+	for(type=0; type<PAIR_TYPES; type++) {
+		statistic_t stat = STATISTIC_T_INIT;
+		double min = NAN, max = NAN;
+		for(i=0; i<n; i++) {
+			for(j=0; j<n; j++) {
+				if(i == j || isnan(latency[i][j])) continue;
+				if(cpu_pair_type(get_cpuinfo(i), get_cpuinfo(j)) != type) continue;
+				calculate_statistics_iterative(&stat, latency[i][j]);
+				if(isnan(min) || latency[i][j] < min) min = latency[i][j];
+				if(isnan(max) || latency[i][j] > max) max = latency[i][j];
+			}
+		}
+		print_table_cell("%{pair}12s, ", cpu_pair_name(type));
+		print_table_cell("%{pairs}6Lu, ", stat.sample_size);
+		print_table_cell("%{min}10.1f, ", min);
+		print_table_cell("%{mean}10.1f, ", stat.mean);
+		print_table_cell("%{max}10.1f, ", max);
+		print_table_line();
+	}
+}
@@ -37,6 +37,13 @@ typedef struct config_t_ {
 		AFFINITY_ROUND_ROBIN
 	} thread_affinity;
 
+	// how the worker pool starts its threads
+	enum {
+		DISPATCH_CONDVAR,	// mutex and condition variable per thread
+		DISPATCH_SPIN		// spin on a generation counter, then futex sleep
+	} thread_dispatch;
+	double dispatch_spin_time;	// seconds a waiting thread spins before it sleeps
+
 	unsigned_huge warmup;
 
 	struct {
@@ -56,8 +63,59 @@ typedef struct config_t_ {
 		unsigned_huge cache_clean_size;
 		range_t *blocksize;
 		range_t *stride;
+		range_t *chains;
+		range_t *distance;
+		range_t *width;
+
+		enum {
+			ALLOC_MALLOC,
+			ALLOC_POPULATE,		// mmap with MAP_POPULATE
+			ALLOC_THP,			// transparent huge pages (madvise)
+			ALLOC_HUGETLB_2M,
+			ALLOC_HUGETLB_1G
+		} alloc;
+
+		enum {
+			NUMA_FIRST_TOUCH,	// pages on the node of the thread touching them first
+			NUMA_LOCAL,			// bound to the node of the main thread
+			NUMA_INTERLEAVE,	// interleaved over all nodes
+			NUMA_BIND,			// bound to node 'numa_node'
+			NUMA_MATRIX			// from every cpu node to every memory node
+		} numa;
+		int numa_node;
+
+		bool detect_cache;	// infer cache levels from the data size sweep
+
+		enum {
+			CACHE_STATE_WARM,	// no clearing between the repetitions
+			CACHE_STATE_FLUSH,	// clflush(opt) of the measured buffer
+			CACHE_STATE_EVICT,	// read an eviction buffer sized from the caches
+			CACHE_STATE_FULL	// evict, then flush eviction and measured buffer
+		} cache_state;
 	} memory;
 
+	// used for memcpy tests
+	struct {
+		range_t *src_offset;	// bytes after a page boundary
+		range_t *dst_offset;
+		range_t *overlap;		// bytes of the source, which are overwritten
+	} copy;
+
+	// used for file i/o tests
+	struct {
+		char *file;				// scratch file, removed afterwards
+		unsigned_huge file_size;
+		range_t *blocksize;
+		range_t *queue_depth;	// requests in flight (aio, uring)
+	} io;
+
+	// used for lock tests
+	struct {
+		range_t *critical_section;	// work units while holding the lock
+		range_t *think_time;		// work units between two acquisitions
+		range_t *read_ratio;		// percentage of read acquisitions (rwlock)
+	} lock;
+
 	// used for mpi
 	range_t *processes;
 	range_t *threads;
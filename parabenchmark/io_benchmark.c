@@ -0,0 +1,643 @@
+/*
+ * io_benchmark.c
+ *
+ * File I/O bandwidth, IOPS and latency of sequential and random reads and
+ * writes through pread/pwrite, O_DIRECT, mmap, POSIX AIO and io_uring.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "io_benchmark.h"
+#include "memory_benchmark.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <aio.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#define __USE_GNU
+#include <fcntl.h>
+
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#define IO_WITH_URING
+#endif
+
+extern config_t config;
+
+/**
+ * alignment of the buffers and offsets (sufficient for O_DIRECT)
+ */
+#define IO_ALIGNMENT 4096
+
+typedef enum {
+	IO_SEQ_READ,
+	IO_RAND_READ,
+	IO_SEQ_WRITE,
+	IO_RAND_WRITE,
+	IO_PATTERN_COUNT
+} io_pattern_t;
+
+char *io_pattern_names[] = {"seqread", "randread", "seqwrite", "randwrite"};
+
+#define IO_IS_WRITE(pattern) ((pattern) == IO_SEQ_WRITE || (pattern) == IO_RAND_WRITE)
+#define IO_IS_RANDOM(pattern) ((pattern) == IO_RAND_READ || (pattern) == IO_RAND_WRITE)
+
+typedef struct io_ring_t_ io_ring_t;
+
+typedef struct {
+	int fd;
+	char *map;					// mapping of the file (mmap only)
+	io_ring_t *ring;			// io_uring only
+	char *buffer;				// one block per request in flight
+	unsigned_huge file_size;
+	unsigned_huge blocksize;
+	unsigned_huge blocks;		// blocks in the file
+	unsigned depth;				// requests in flight
+	io_pattern_t pattern;
+	unsigned_huge position;		// next block (sequential) or random state
+	double *latency;			// seconds per request
+} io_job_t;
+
+typedef bool (*io_run_fn_t)(io_job_t *job, unsigned_huge requests);
+typedef bool (*io_open_fn_t)(io_job_t *job);
+typedef void (*io_close_fn_t)(io_job_t *job);
+
+typedef struct {
+	char *name;
+	io_run_fn_t run;
+	io_open_fn_t open_fn;	// optional
+	io_close_fn_t close_fn;	// optional
+	bool direct;			// open the file with O_DIRECT
+	bool async;				// uses the queue depth
+} io_engine_t;
+
+/**
+ * print the error of a failed call only once per test point
+ */
+bool io_warned = false;
+
+void io_warn(const char *call, int err) {
+	if(io_warned) return;
+	_printf("WARNING: %s failed: %s\n", call, strerror(err));
+	io_warned = true;
+}
+
+/**
+ * offset of the next request, sequential requests wrap around at the end
+ * of the file
+ */
+off_t io_next_offset(io_job_t *job) {
+	unsigned_huge block;
+	if(IO_IS_RANDOM(job->pattern)) {
+		job->position = job->position * RANDOM_A + RANDOM_C;
+		block = (job->position >> 16) % job->blocks;
+	}
+	else {
+		block = job->position++ % job->blocks;
+	}
+	return (off_t)(block * job->blocksize);
+}
+
+/**
+ * pread/pwrite, also used with O_DIRECT
+ */
+bool io_run_pread(io_job_t *job, unsigned_huge requests) {
+	bool write = IO_IS_WRITE(job->pattern);
+	unsigned_huge r;
+	for(r=0; r<requests; r++) {
+		off_t offset = io_next_offset(job);
+		double start;
+		tick2(MODE_START, &start);
+		ssize_t done = write
+				? pwrite(job->fd, job->buffer, job->blocksize, offset)
+				: pread(job->fd, job->buffer, job->blocksize, offset);
+		job->latency[r] = tick2(MODE_END, &start);
+		if(done != (ssize_t)job->blocksize) {
+			io_warn(write ? "pwrite" : "pread", done < 0 ? errno : EIO);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * map the whole file, the access pattern is passed to the kernel
+ */
+bool io_open_mmap(io_job_t *job) {
+	job->map = (char *)mmap(NULL, job->file_size, PROT_READ | PROT_WRITE, MAP_SHARED, job->fd, 0);
+	if(job->map == MAP_FAILED) {
+		job->map = NULL;
+		io_warn("mmap", errno);
+		return false;
+	}
+	if(madvise(job->map, job->file_size, IO_IS_RANDOM(job->pattern) ? MADV_RANDOM : MADV_SEQUENTIAL) != 0) {
+		io_warn("madvise", errno);
+	}
+	return true;
+}
+
+void io_close_mmap(io_job_t *job) {
+	if(job->map != NULL) munmap(job->map, job->file_size);
+	job->map = NULL;
+}
+
+bool io_run_mmap(io_job_t *job, unsigned_huge requests) {
+	bool write = IO_IS_WRITE(job->pattern);
+	unsigned_huge r;
+	for(r=0; r<requests; r++) {
+		off_t offset = io_next_offset(job);
+		double start;
+		tick2(MODE_START, &start);
+		if(write) memcpy(job->map + offset, job->buffer, job->blocksize);
+		else memcpy(job->buffer, job->map + offset, job->blocksize);
+		job->latency[r] = tick2(MODE_END, &start);
+	}
+	return true;
+}
+
+/**
+ * POSIX AIO: keep 'depth' requests in flight, which are completed in the
+ * order of submission
+ */
+bool io_aio_submit(io_job_t *job, struct aiocb *cb, unsigned slot, double *submitted) {
+	memset(cb, 0, sizeof(struct aiocb));
+	cb->aio_fildes = job->fd;
+	cb->aio_offset = io_next_offset(job);
+	cb->aio_buf = job->buffer + slot * job->blocksize;
+	cb->aio_nbytes = job->blocksize;
+	tick2(MODE_START, submitted);
+	int err = IO_IS_WRITE(job->pattern) ? aio_write(cb) : aio_read(cb);
+	if(err != 0) {
+		io_warn(IO_IS_WRITE(job->pattern) ? "aio_write" : "aio_read", errno);
+		return false;
+	}
+	return true;
+}
+
+bool io_run_aio(io_job_t *job, unsigned_huge requests) {
+	struct aiocb cbs[job->depth];
+	double submitted[job->depth];
+	unsigned_huge issued = 0, completed = 0;
+	bool ok = true;
+	unsigned slot;
+	for(slot=0; slot<job->depth && issued<requests; slot++) {
+		if(!io_aio_submit(job, &cbs[slot], slot, &submitted[slot])) return false;
+		issued++;
+	}
+	slot = 0;
+	while(completed < issued) {
+		const struct aiocb *list[1] = {&cbs[slot]};
+		while(aio_error(&cbs[slot]) == EINPROGRESS) {
+			aio_suspend(list, 1, NULL);
+		}
+		ssize_t done = aio_return(&cbs[slot]);
+		job->latency[completed++] = tick2(MODE_END, &submitted[slot]);
+		if(done != (ssize_t)job->blocksize) {
+			io_warn("aio", done < 0 ? aio_error(&cbs[slot]) : EIO);
+			ok = false;
+		}
+		if(ok && issued < requests) {
+			if(!io_aio_submit(job, &cbs[slot], slot, &submitted[slot])) ok = false;
+			else issued++;
+		}
+		slot = (slot + 1) % job->depth;
+	}
+	return ok;
+}
+
+#ifdef IO_WITH_URING
+/**
+ * io_uring through the raw system calls (no liburing)
+ */
+struct io_ring_t_ {
+	int fd;
+	unsigned *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_size, cq_size, sqes_size;
+	unsigned to_submit;
+	double *submitted;	// per slot
+};
+
+bool io_open_uring(io_job_t *job) {
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int fd = syscall(__NR_io_uring_setup, job->depth, &params);
+	if(fd < 0) {
+		io_warn("io_uring_setup (io_uring not supported by the kernel?)", errno);
+		return false;
+	}
+	io_ring_t *ring = (io_ring_t *)calloc(1, sizeof(io_ring_t));
+	ring->fd = fd;
+	ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			fd, IORING_OFF_SQ_RING);
+	ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			fd, IORING_OFF_CQ_RING);
+	ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	job->ring = ring;
+	if(ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		io_warn("mmap of io_uring", errno);
+		return false;
+	}
+	char *sq = (char *)ring->sq_ptr, *cq = (char *)ring->cq_ptr;
+	ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+	ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+	ring->submitted = (double *)malloc(job->depth * sizeof(double));
+	return true;
+}
+
+void io_close_uring(io_job_t *job) {
+	io_ring_t *ring = job->ring;
+	if(ring == NULL) return;
+	if(ring->sq_ptr != NULL && ring->sq_ptr != MAP_FAILED) munmap(ring->sq_ptr, ring->sq_size);
+	if(ring->cq_ptr != NULL && ring->cq_ptr != MAP_FAILED) munmap(ring->cq_ptr, ring->cq_size);
+	if(ring->sqes != NULL && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+	close(ring->fd);
+	free(ring->submitted);
+	free(ring);
+	job->ring = NULL;
+}
+
+void io_uring_queue(io_job_t *job, unsigned slot) {
+	io_ring_t *ring = job->ring;
+	unsigned tail = *ring->sq_tail;
+	unsigned index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	sqe->opcode = IO_IS_WRITE(job->pattern) ? IORING_OP_WRITE : IORING_OP_READ;
+	sqe->fd = job->fd;
+	sqe->addr = (uintptr_t)(job->buffer + slot * job->blocksize);
+	sqe->len = job->blocksize;
+	sqe->off = io_next_offset(job);
+	sqe->user_data = slot;
+	ring->sq_array[index] = index;
+	tick2(MODE_START, &ring->submitted[slot]);
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	ring->to_submit++;
+}
+
+bool io_run_uring(io_job_t *job, unsigned_huge requests) {
+	io_ring_t *ring = job->ring;
+	unsigned_huge issued = 0, completed = 0;
+	bool ok = true;
+	unsigned slot;
+	ring->to_submit = 0;
+	for(slot=0; slot<job->depth && issued<requests; slot++) {
+		io_uring_queue(job, slot);
+		issued++;
+	}
+	while(completed < issued) {
+		int ret = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, 1,
+				IORING_ENTER_GETEVENTS, NULL, 0);
+		if(ret < 0) {
+			if(errno == EINTR) continue;
+			io_warn("io_uring_enter", errno);
+			return false;
+		}
+		ring->to_submit = 0;
+		unsigned head = *ring->cq_head;
+		unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+		for(; head != tail; head++) {
+			struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+			slot = cqe->user_data;
+			job->latency[completed++] = tick2(MODE_END, &ring->submitted[slot]);
+			if(cqe->res != (int)job->blocksize) {
+				io_warn("io_uring request", cqe->res < 0 ? -cqe->res : EIO);
+				ok = false;
+			}
+			if(ok && issued < requests) {
+				io_uring_queue(job, slot);
+				issued++;
+			}
+		}
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+	}
+	return ok;
+}
+#endif
+
+io_engine_t io_engines[] = {
+		{"pread", &io_run_pread, NULL, NULL, false, false},
+		{"direct", &io_run_pread, NULL, NULL, true, false},
+		{"mmap", &io_run_mmap, &io_open_mmap, &io_close_mmap, false, false},
+		{"aio", &io_run_aio, NULL, NULL, true, true},
+#ifdef IO_WITH_URING
+		{"uring", &io_run_uring, &io_open_uring, &io_close_uring, true, true},
+#endif
+		{NULL, NULL, NULL, NULL, false, false}
+};
+
+/**
+ * Create the scratch file with 'config.io.file_size' bytes. An existing
+ * file is never overwritten
+ */
+bool io_create_file() {
+	int fd = open(config.io.file, O_CREAT | O_EXCL | O_WRONLY, 0600);
+	if(fd < 0) {
+		_printf("WARNING: couldn't create scratch file %s: %s\n", config.io.file, strerror(errno));
+		return false;
+	}
+	size_t chunk = MB;
+	char *buffer = (char *)malloc(chunk);
+	memset(buffer, 0xa5, chunk);
+	unsigned_huge written = 0;
+	while(written < config.io.file_size) {
+		size_t size = config.io.file_size - written < chunk ? config.io.file_size - written : chunk;
+		ssize_t done = write(fd, buffer, size);
+		if(done <= 0) {
+			_printf("WARNING: couldn't write scratch file %s: %s\n", config.io.file,
+					strerror(done < 0 ? errno : EIO));
+			free(buffer);
+			close(fd);
+			unlink(config.io.file);
+			return false;
+		}
+		written += done;
+	}
+	free(buffer);
+	fsync(fd);
+	close(fd);
+	return true;
+}
+
+/**
+ * Write back dirty pages and drop the file from the page cache, unless the
+ * cache state is warm. Buffered reads are then served by the device
+ */
+void io_drop_cache(io_job_t *job) {
+	if(config.memory.cache_state == CACHE_STATE_WARM) return;
+	if(job->map != NULL) {
+		msync(job->map, job->file_size, MS_SYNC);
+		madvise(job->map, job->file_size, MADV_DONTNEED);
+	}
+	fdatasync(job->fd);
+	posix_fadvise(job->fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+/**
+ * Writes through the page cache are written back at the end of each
+ * repetition (included in the time)
+ */
+void io_sync(io_engine_t *engine, io_job_t *job) {
+	if(!IO_IS_WRITE(job->pattern) || engine->direct) return;
+	if(job->map != NULL) msync(job->map, job->file_size, MS_SYNC);
+	else fdatasync(job->fd);
+}
+
+/**
+ * Run 'config.steps.number' requests per repetition and print one table
+ * line. Returns -1 on error, 0 if the point was skipped
+ */
+int io_test(io_engine_t *engine, io_pattern_t pattern, unsigned_huge blocksize, unsigned depth) {
+	if(blocksize == 0 || blocksize > config.io.file_size) return 0;
+	if(engine->direct && blocksize % IO_ALIGNMENT != 0) {
+		_printf("WARNING: %s needs block sizes, which are a multiple of %d bytes\n",
+				engine->name, IO_ALIGNMENT);
+		return 0;
+	}
+	int fd = open(config.io.file, O_RDWR | (engine->direct ? O_DIRECT : 0));
+	if(fd < 0) {
+		_printf("WARNING: couldn't open %s%s: %s\n", config.io.file,
+				engine->direct ? " with O_DIRECT" : "", strerror(errno));
+		return 0;
+	}
+
+	unsigned_huge steps = config.steps.number;
+	unsigned_huge repetitions = config.repetitions.number;
+	io_job_t job;
+	memset(&job, 0, sizeof(job));
+	job.fd = fd;
+	job.file_size = config.io.file_size;
+	job.blocksize = blocksize;
+	job.blocks = config.io.file_size / blocksize;
+	job.depth = depth;
+	job.pattern = pattern;
+	job.position = 0;
+	job.latency = (double *)malloc((repetitions + 1) * steps * sizeof(double));
+	void *buffer = NULL;
+	if(posix_memalign(&buffer, IO_ALIGNMENT, depth * blocksize) != 0 || job.latency == NULL) {
+		_printf("WARNING: couldn't allocate buffers for io benchmark\n");
+		free(job.latency);
+		close(fd);
+		return -1;
+	}
+	job.buffer = (char *)buffer;
+	memset(job.buffer, 0x5a, depth * blocksize);
+
+	io_warned = false;
+	bool ok = engine->open_fn == NULL || engine->open_fn(&job);
+	double *time_single = (double *)malloc((repetitions + 1) * sizeof(double));
+	int r;
+	for(r=-(int)config.warmup; ok && r<(int)repetitions; r++) {
+		io_job_t rep = job;
+		// warmup repetitions overwrite the latencies of the first repetition
+		rep.latency = job.latency + (r < 0 ? 0 : r) * steps;
+		io_drop_cache(&job);
+		sched_yield();
+		double start;
+		tick2(MODE_START, &start);
+		ok = engine->run(&rep, steps);
+		io_sync(engine, &rep);
+		double time = tick2(MODE_END, &start);
+		job.position = rep.position;
+		if(r >= 0) time_single[r] = time;
+	}
+	if(engine->close_fn != NULL) engine->close_fn(&job);
+	close(fd);
+	free(buffer);
+
+	if(ok) {
+		statistic_t stat_time = middle_stat(time_single, repetitions);
+		double requests = steps / stat_time.mean;
+		unsigned_huge samples = repetitions * steps;
+		double *latency = job.latency;
+		double mean_latency = 0;
+		unsigned_huge i;
+		for(i=0; i<samples; i++) mean_latency += latency[i];
+		mean_latency /= samples;
+
+		print_table_cell("%{blocksize}9Lu, ", blocksize);
+		print_table_cell("%{queue depth}5u, ", engine->async ? depth : 1);
+		print_table_cell("%{repetitions}5Lu, ", repetitions);
+		print_table_cell("%{requests per repetition}7Lu, ", steps);
+		print_table_cell("%{bandwidth}" BIG_PRECISSION "f, ", requests * blocksize / MB);
+		print_table_cell("%{bandwidth deviation}" BIG_PRECISSION "f, ",
+				requests * blocksize / MB * stat_time.deviation / stat_time.mean);
+		print_table_cell("%{iops}" BIG_PRECISSION "f, ", requests);
+		print_table_cell("%{latency mean us}" PRECISSION "f, ", mean_latency * 1e6);
+		print_table_cell("%{latency p50 us}" PRECISSION "f, ", percentile(latency, samples, 0.5) * 1e6);
+		print_table_cell("%{latency p90 us}" PRECISSION "f, ", percentile(latency, samples, 0.9) * 1e6);
+		print_table_cell("%{latency p99 us}" PRECISSION "f, ", percentile(latency, samples, 0.99) * 1e6);
+		print_table_cell("%{latency p99.9 us}" PRECISSION "f, ", percentile(latency, samples, 0.999) * 1e6);
+		print_table_cell("%{latency max us}" PRECISSION "f, ", percentile(latency, samples, 1) * 1e6);
+		print_table_line();
+	}
+	free(time_single);
+	free(job.latency);
+	return ok ? 1 : 0;
+}
+
+void start_io_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("io benchmark\n");
+	_printf("scratch file: %s, %Lu bytes\n", config.io.file, config.io.file_size);
+	_printf("one step is one request of blocksize bytes, latency is measured from submission to completion\n");
+	_printf("page cache: %s\n", config.memory.cache_state == CACHE_STATE_WARM
+			? "warm" : "dropped before every repetition");
+	_printf("writes through the page cache are synced at the end of every repetition\n");
+	_printf("queue depth is only used by aio and uring\n");
+	_printf("bandwidth is Mebibyte / second = 1024*1024 byte / second\n");
+	_printf("###############\n");
+
+	if(option == NULL) option = "all";
+
+	// selected engines and patterns
+	unsigned engine_count = sizeof(io_engines) / sizeof(io_engine_t) - 1;
+	bool engine_selected[engine_count];
+	bool patterns[IO_PATTERN_COUNT];
+	memset(engine_selected, 0, sizeof(engine_selected));
+	memset(patterns, 0, sizeof(patterns));
+	unsigned option_count, i, j;
+	char **options = get_token_array(option, &option_count);
+	for(i=0; i<option_count; i++) {
+		bool found = false;
+		bool all = strcmp(options[i], "all") == 0;
+		for(j=0; j<engine_count; j++) {
+			if(all || strcmp(options[i], io_engines[j].name) == 0) {
+				engine_selected[j] = found = true;
+			}
+		}
+		for(j=0; j<IO_PATTERN_COUNT; j++) {
+			if(all || strcmp(options[i], io_pattern_names[j]) == 0
+					|| (strcmp(options[i], "read") == 0 && !IO_IS_WRITE(j))
+					|| (strcmp(options[i], "write") == 0 && IO_IS_WRITE(j))) {
+				patterns[j] = found = true;
+			}
+		}
+		if(!found) {
+			_printf("WARNING: unknown option for io benchmark: %s\n", options[i]);
+		}
+	}
+	// without engine (pattern) in the option, all engines (patterns) are used
+	io_engine_t *engines[engine_count];
+	unsigned selected_engines = 0, selected_patterns = 0;
+	for(j=0; j<engine_count; j++) {
+		if(engine_selected[j]) engines[selected_engines++] = &io_engines[j];
+	}
+	if(selected_engines == 0) {
+		for(j=0; j<engine_count; j++) engines[selected_engines++] = &io_engines[j];
+	}
+	for(j=0; j<IO_PATTERN_COUNT; j++) selected_patterns += patterns[j];
+	if(selected_patterns == 0) {
+		for(j=0; j<IO_PATTERN_COUNT; j++) patterns[j] = true;
+	}
+
+	if(!io_create_file()) return;
+
+	io_engine_t *engine = NULL;
+	io_pattern_t pattern = IO_SEQ_READ;
+	char *additional_info = NULL;
+
+	int set_engine_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_engine;
+		get_iteration_value("engine", level, vec, &num_engine);
+		if(num_engine >= selected_engines) return NESTED_FOR_BREAK;
+		engine = engines[num_engine];
+		return 0;
+	}
+
+	int set_pattern_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_pattern;
+		get_iteration_value("pattern", level, vec, &num_pattern);
+		if(num_pattern >= IO_PATTERN_COUNT) return NESTED_FOR_BREAK;
+		if(!patterns[num_pattern]) return NESTED_FOR_CONT;
+		pattern = num_pattern;
+		free(additional_info);
+		additional_info = NULL;
+		strappend(&additional_info, engine->name);
+		strappend(&additional_info, ", ");
+		strappend(&additional_info, io_pattern_names[pattern]);
+		print_table_set_additional_info("engine, pattern", additional_info);
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge blocksize; get_iteration_value("blocksize", level, vec, &blocksize);
+		unsigned_huge depth; get_iteration_value("depth", level, vec, &depth);
+		// synchronous engines only run with the first queue depth
+		if(!engine->async && depth != config.io.queue_depth->start) return 0;
+		if(depth == 0) return 0;
+		if(io_test(engine, pattern, blocksize, depth) < 0) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t engine_loop = FOR_LOOP_T_INIT;
+	engine_loop.var.name = "engine";
+	engine_loop.var.start = 0;
+	engine_loop.var.end = selected_engines;
+	engine_loop.step_fn = &step_increment;
+	engine_loop.inner_start_fn = &set_engine_fn;
+
+	for_loop_t pattern_loop = FOR_LOOP_T_INIT;
+	pattern_loop.var.name = "pattern";
+	pattern_loop.var.start = 0;
+	pattern_loop.var.end = IO_PATTERN_COUNT;
+	pattern_loop.step_fn = &step_increment;
+	pattern_loop.inner_start_fn = &set_pattern_fn;
+
+	for_loop_t blocksize_loop = FOR_LOOP_T_INIT;
+	blocksize_loop.var.name = "blocksize";
+	blocksize_loop.var.range = config.io.blocksize;
+	blocksize_loop.step_fn = &step_range;
+
+	for_loop_t depth_loop = FOR_LOOP_T_INIT;
+	depth_loop.var.name = "depth";
+	depth_loop.var.range = config.io.queue_depth;
+	depth_loop.step_fn = &step_range;
+
+	engine_loop.next = &pattern_loop;
+	pattern_loop.next = &blocksize_loop;
+	blocksize_loop.next = &depth_loop;
+
+	nested_for_loop(&engine_loop, fn);
+
+	unlink(config.io.file);
+	free(additional_info);
+}
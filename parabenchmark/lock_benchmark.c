@@ -0,0 +1,472 @@
+/*
+ * lock_benchmark.c
+ *
+ * Contended critical sections for different lock algorithms: pthread
+ * mutexes (normal and adaptive), pthread spinlocks, a ticket lock, an MCS
+ * queue lock and pthread rwlocks with a configurable share of readers.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "lock_benchmark.h"
+#include "memory_benchmark.h"
+#include "pthread_functions.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+
+#define __USE_GNU
+#include <sched.h>
+#include <pthread.h>
+
+extern config_t config;
+
+/**
+ * distance of data written by different threads (avoids false sharing)
+ */
+#define LOCK_PADDING 128
+
+/**
+ * spinning threads yield the processor after this many polls, so that
+ * oversubscribed runs still make progress
+ */
+#define LOCK_SPIN_YIELD 1024
+
+typedef enum {
+	LOCK_MUTEX,
+	LOCK_MUTEX_ADAPTIVE,	// spins a while before it sleeps
+	LOCK_SPINLOCK,
+	LOCK_TICKET,			// fifo, all waiters spin on one counter
+	LOCK_MCS,				// fifo, every waiter spins on its own node
+	LOCK_RWLOCK,
+	LOCK_MECHANISM_COUNT
+} lock_mechanism_t;
+
+char *lock_mechanism_names[] = {"mutex", "mutex-adaptive", "spinlock", "ticket", "mcs", "rwlock"};
+
+struct lock_qnode_t_;
+typedef struct lock_qnode_t_ lock_qnode_t;
+struct lock_qnode_t_ {
+	lock_qnode_t * volatile next;
+	volatile int locked;
+} __attribute__((aligned(LOCK_PADDING)));
+
+typedef struct {
+	lock_mechanism_t mechanism;
+	unsigned num_threads;
+	unsigned_huge steps;
+	unsigned_huge critical_section;
+	unsigned_huge think_time;
+	unsigned_huge read_ratio;
+
+	pthread_mutex_t mutex;
+	pthread_spinlock_t spinlock;
+	pthread_rwlock_t rwlock;
+	volatile unsigned ticket_next __attribute__((aligned(LOCK_PADDING)));
+	volatile unsigned ticket_serving __attribute__((aligned(LOCK_PADDING)));
+	lock_qnode_t * volatile mcs_tail __attribute__((aligned(LOCK_PADDING)));
+
+	// protected by the lock, written by writers only
+	volatile unsigned_huge counter __attribute__((aligned(LOCK_PADDING)));
+	volatile long long release_time;	// ns of the last write release
+	volatile unsigned holder;			// tid of the last writer
+
+	volatile unsigned started __attribute__((aligned(LOCK_PADDING)));
+	volatile int stop __attribute__((aligned(LOCK_PADDING)));
+} lock_shared_t;
+
+/**
+ * state and results of one thread
+ */
+typedef struct {
+	lock_qnode_t qnode;
+	lock_shared_t *shared;
+	unsigned_huge random;
+
+	unsigned_huge acquisitions;
+	unsigned_huge writes;
+	double time;
+
+	double *handover;	// ns from release to acquisition by a waiting thread
+	unsigned_huge handovers;
+} __attribute__((aligned(LOCK_PADDING))) lock_thread_data_t;
+
+static inline void lock_pause(unsigned *spins) {
+	if(++*spins % LOCK_SPIN_YIELD == 0) sched_yield();
+	else __asm__ __volatile__ ("pause" ::: "memory");
+}
+
+/**
+ * 'units' iterations of a dependent decrement, which stays the same
+ * at every optimization level
+ */
+static inline void lock_work(unsigned_huge units) {
+	if(units == 0) return;
+	__asm__ __volatile__ (
+		"1:\n\t"
+		"dec %0\n\t"
+		"jnz 1b\n\t"
+		: "+r" (units) : : "cc");
+}
+
+static inline long long lock_now() {
+	timespec_t now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (long long) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/**
+ * nanoseconds of one work unit
+ */
+double lock_work_unit_time() {
+	unsigned_huge units = 10000000;
+	timespec_t tmp;
+	tick_precise(MODE_START, &tmp);
+	lock_work(units);
+	return tick_precise(MODE_END, &tmp) * 1e9 / units;
+}
+
+static inline void lock_acquire(lock_thread_data_t *data, bool write) {
+	lock_shared_t *shared = data->shared;
+	unsigned spins = 0;
+	switch(shared->mechanism) {
+	case LOCK_MUTEX:
+	case LOCK_MUTEX_ADAPTIVE:
+		pthread_mutex_lock(&shared->mutex);
+		break;
+	case LOCK_SPINLOCK:
+		pthread_spin_lock(&shared->spinlock);
+		break;
+	case LOCK_TICKET: {
+		unsigned ticket = __sync_fetch_and_add(&shared->ticket_next, 1);
+		while(shared->ticket_serving != ticket) lock_pause(&spins);
+		break;
+	}
+	case LOCK_MCS: {
+		lock_qnode_t *node = &data->qnode;
+		node->next = NULL;
+		node->locked = 1;
+		lock_qnode_t *pred = __sync_lock_test_and_set(&shared->mcs_tail, node);
+		if(pred != NULL) {
+			pred->next = node;
+			while(node->locked) lock_pause(&spins);
+		}
+		break;
+	}
+	case LOCK_RWLOCK:
+		if(write) pthread_rwlock_wrlock(&shared->rwlock);
+		else pthread_rwlock_rdlock(&shared->rwlock);
+		break;
+	default: break;
+	}
+	__sync_synchronize();
+}
+
+static inline void lock_release(lock_thread_data_t *data) {
+	lock_shared_t *shared = data->shared;
+	unsigned spins = 0;
+	__sync_synchronize();
+	switch(shared->mechanism) {
+	case LOCK_MUTEX:
+	case LOCK_MUTEX_ADAPTIVE:
+		pthread_mutex_unlock(&shared->mutex);
+		break;
+	case LOCK_SPINLOCK:
+		pthread_spin_unlock(&shared->spinlock);
+		break;
+	case LOCK_TICKET:
+		shared->ticket_serving++;
+		break;
+	case LOCK_MCS: {
+		lock_qnode_t *node = &data->qnode;
+		if(node->next == NULL) {
+			if(__sync_bool_compare_and_swap(&shared->mcs_tail, node, NULL)) break;
+			// a successor swapped the tail, but has not linked itself yet
+			while(node->next == NULL) lock_pause(&spins);
+		}
+		node->next->locked = 0;
+		break;
+	}
+	case LOCK_RWLOCK:
+		pthread_rwlock_unlock(&shared->rwlock);
+		break;
+	default: break;
+	}
+}
+
+/**
+ * Acquire the lock until one of the threads has done 'steps' acquisitions.
+ * A handover is recorded, if the lock was released by another thread
+ * after the acquiring thread started to wait for it
+ */
+void *lock_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	lock_thread_data_t *data = (lock_thread_data_t*) arg->data;
+	lock_shared_t *shared = data->shared;
+	unsigned tid = arg->tid;
+	unsigned spins = 0;
+	bool write = true;
+
+	data->acquisitions = 0;
+	data->writes = 0;
+	data->handovers = 0;
+
+	__sync_add_and_fetch(&shared->started, 1);
+	while(shared->started < shared->num_threads) lock_pause(&spins);
+
+	timespec_t tmp;
+	tick_precise(MODE_START, &tmp);
+	while(!shared->stop) {
+		if(shared->mechanism == LOCK_RWLOCK) {
+			data->random = data->random * RANDOM_A + RANDOM_C;
+			write = (data->random >> 33) % 100 >= shared->read_ratio;
+		}
+		long long request = lock_now();
+		lock_acquire(data, write);
+		long long acquired = lock_now();
+		if(shared->holder != tid && shared->release_time > request) {
+			data->handover[data->handovers++] = acquired - shared->release_time;
+		}
+
+		if(write) shared->counter++;
+		lock_work(shared->critical_section);
+		if(write) {
+			data->writes++;
+			shared->holder = tid;
+			shared->release_time = lock_now();
+		}
+		lock_release(data);
+
+		if(++data->acquisitions >= shared->steps) shared->stop = 1;
+		lock_work(shared->think_time);
+	}
+	data->time = tick_precise(MODE_END, &tmp);
+	return (void *)NULL;
+}
+
+void lock_test(lock_mechanism_t mechanism, unsigned num_threads, unsigned_huge critical_section,
+		unsigned_huge think_time, unsigned_huge read_ratio) {
+	if(num_threads == 0) return;
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL) {
+		_printf("Cannot allocate enough space for threads\n");
+		return;
+	}
+	unsigned_huge steps = config.steps.number;
+	unsigned_huge repetitions = config.repetitions.number;
+
+	lock_shared_t *shared = NULL;
+	lock_thread_data_t *data = NULL;
+	if(posix_memalign((void **)&shared, LOCK_PADDING, sizeof(lock_shared_t)) != 0
+			|| posix_memalign((void **)&data, LOCK_PADDING, num_threads * sizeof(lock_thread_data_t)) != 0) {
+		_printf("WARNING: couldn't allocate lock for lock benchmark\n");
+		free(shared);
+		return;
+	}
+	memset(shared, 0, sizeof(lock_shared_t));
+	shared->mechanism = mechanism;
+	shared->num_threads = num_threads;
+	shared->steps = steps;
+	shared->critical_section = critical_section;
+	shared->think_time = think_time;
+	shared->read_ratio = mechanism == LOCK_RWLOCK ? read_ratio : 0;
+
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, mechanism == LOCK_MUTEX_ADAPTIVE
+			? PTHREAD_MUTEX_ADAPTIVE_NP : PTHREAD_MUTEX_NORMAL);
+	pthread_mutex_init(&shared->mutex, &attr);
+	pthread_mutexattr_destroy(&attr);
+	pthread_spin_init(&shared->spinlock, PTHREAD_PROCESS_PRIVATE);
+	pthread_rwlock_init(&shared->rwlock, NULL);
+
+	unsigned i;
+	memset(data, 0, num_threads * sizeof(lock_thread_data_t));
+	for(i=0; i<num_threads; i++) {
+		data[i].shared = shared;
+		data[i].random = i + 1;
+		data[i].handover = (double*)malloc(steps * sizeof(double));
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &lock_loop;
+		args[i].data = &data[i];
+	}
+	double *handover = (double*)malloc(num_threads * steps * sizeof(double));
+
+	double *throughput = (double*)malloc((repetitions+1)*sizeof(double));
+	double *fairness = (double*)malloc((repetitions+1)*sizeof(double));
+	double *jain = (double*)malloc((repetitions+1)*sizeof(double));
+	double *handover_median = (double*)malloc((repetitions+1)*sizeof(double));
+	double *handover_p99 = (double*)malloc((repetitions+1)*sizeof(double));
+	bool exclusion = true;
+
+	int r;
+	for(r=-config.warmup; r<(int)repetitions; r++) {
+		shared->started = 0;
+		shared->stop = 0;
+		shared->counter = 0;
+		shared->holder = -1;
+		shared->release_time = 0;
+
+		threads_prepare(args, num_threads);
+		threads_start(args, num_threads);
+		threads_join(args, num_threads);
+		if(r < 0) continue;
+
+		double time = 0, sum = 0, sum_squares = 0;
+		unsigned_huge min = -1, max = 0, writes = 0, handovers = 0;
+		for(i=0; i<num_threads; i++) {
+			unsigned_huge n = data[i].acquisitions;
+			time = data[i].time > time ? data[i].time : time;
+			sum += n;
+			sum_squares += (double)n * n;
+			min = n < min ? n : min;
+			max = n > max ? n : max;
+			writes += data[i].writes;
+			memcpy(handover + handovers, data[i].handover, data[i].handovers * sizeof(double));
+			handovers += data[i].handovers;
+		}
+		if(writes != shared->counter) exclusion = false;
+
+		throughput[r] = sum / time;
+		fairness[r] = max > 0 ? (double)min / max : NAN;
+		jain[r] = sum_squares > 0 ? sum * sum / (num_threads * sum_squares) : NAN;
+		handover_median[r] = percentile(handover, handovers, 0.5);
+		handover_p99[r] = percentile(handover, handovers, 0.99);
+	}
+	if(!exclusion) {
+		_printf("WARNING: %s lost updates of the protected counter\n", lock_mechanism_names[mechanism]);
+	}
+
+	statistic_t throughput_stat = middle_stat(throughput, repetitions);
+	statistic_t fairness_stat = middle_stat(fairness, repetitions);
+	statistic_t jain_stat = middle_stat(jain, repetitions);
+	statistic_t median_stat = middle_stat(handover_median, repetitions);
+	statistic_t p99_stat = middle_stat(handover_p99, repetitions);
+
+	for(i=0; i<num_threads; i++) free(data[i].handover);
+	free(handover);
+	free(throughput);
+	free(fairness);
+	free(jain);
+	free(handover_median);
+	free(handover_p99);
+	pthread_mutex_destroy(&shared->mutex);
+	pthread_spin_destroy(&shared->spinlock);
+	pthread_rwlock_destroy(&shared->rwlock);
+	free(data);
+	free(shared);
+
+	print_table_cell("%{threads}5u, ", num_threads);
+	print_table_cell("%{critical section}9Lu, ", critical_section);
+	print_table_cell("%{think time}9Lu, ", think_time);
+	print_table_cell("%{read ratio}5Lu, ", mechanism == LOCK_RWLOCK ? read_ratio : 0);
+	print_table_cell("%{steps}9Lu, ", steps);
+	print_table_cell("%{repetitions}6Lu, ", repetitions);
+	print_table_cell("%{acquisitions per s}" PRECISSION "f, ", throughput_stat.mean);
+	print_table_cell("%{deviation}" PRECISSION "f, ", throughput_stat.deviation);
+	print_table_cell("%{min/max share}" PRECISSION "f, ", fairness_stat.mean);
+	print_table_cell("%{jain index}" PRECISSION "f, ", jain_stat.mean);
+	print_table_cell("%{handover median ns}" PRECISSION "f, ", median_stat.mean);
+	print_table_cell("%{handover p99 ns}" PRECISSION "f, ", p99_stat.mean);
+	print_table_line();
+}
+
+void start_lock_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("lock benchmark\n");
+	_printf("critical section and think time in work units, one unit takes %.2f ns\n", lock_work_unit_time());
+	_printf("steps: acquisitions of the fastest thread, which ends the repetition\n");
+	_printf("min/max share: fewest divided by most acquisitions of a thread\n");
+	_printf("handover: release until acquisition by a thread, which waited for it (rwlock: after writers only)\n");
+	_printf("spinning threads yield after %d polls\n", LOCK_SPIN_YIELD);
+	_printf("###############\n");
+
+	if(option == NULL || strcmp(option, "all") == 0) option = "mutex,mutex-adaptive,spinlock,ticket,mcs,rwlock";
+
+	get_thread_array(config.threads->end);
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	lock_mechanism_t mechanism = LOCK_MUTEX;
+
+	int set_mechanism_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+		for(mechanism=0; mechanism<LOCK_MECHANISM_COUNT; mechanism++) {
+			if(strcmp(options[num_option], lock_mechanism_names[mechanism]) == 0) break;
+		}
+		if(mechanism == LOCK_MECHANISM_COUNT) {
+			_printf("WARNING: unknown option for lock benchmark: %s\n", options[num_option]);
+			return NESTED_FOR_CONT;
+		}
+		print_table_set_additional_info("lock", lock_mechanism_names[mechanism]);
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge critical_section; get_iteration_value("critical section", level, vec, &critical_section);
+		unsigned_huge think_time; get_iteration_value("think time", level, vec, &think_time);
+		unsigned_huge read_ratio; get_iteration_value("read ratio", level, vec, &read_ratio);
+		unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
+		// only readers and writers can share the lock
+		if(mechanism != LOCK_RWLOCK && read_ratio != config.lock.read_ratio->start) return 0;
+		if(read_ratio > 100) return 0;
+		lock_test(mechanism, num_threads, critical_section, think_time, read_ratio);
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_mechanism_fn;
+
+	for_loop_t critical_section_loop = FOR_LOOP_T_INIT;
+	critical_section_loop.var.name = "critical section";
+	critical_section_loop.var.range = config.lock.critical_section;
+	critical_section_loop.step_fn = &step_range;
+
+	for_loop_t think_time_loop = FOR_LOOP_T_INIT;
+	think_time_loop.var.name = "think time";
+	think_time_loop.var.range = config.lock.think_time;
+	think_time_loop.step_fn = &step_range;
+
+	for_loop_t read_ratio_loop = FOR_LOOP_T_INIT;
+	read_ratio_loop.var.name = "read ratio";
+	read_ratio_loop.var.range = config.lock.read_ratio;
+	read_ratio_loop.step_fn = &step_range;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+
+	option_loop.next = &critical_section_loop;
+	critical_section_loop.next = &think_time_loop;
+	think_time_loop.next = &read_ratio_loop;
+	read_ratio_loop.next = &thread_loop;
+
+	nested_for_loop(&option_loop, fn);
+}
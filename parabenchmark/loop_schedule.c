@@ -0,0 +1,214 @@
+/*
+ * loop_schedule.c
+ *
+ * Distribution of loop iterations among the pool threads: static blocks,
+ * cyclic chunks, dynamic and guided self-scheduling and work stealing.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "loop_schedule.h"
+#include "pthread_functions.h"
+#include "print_functions.h"
+
+#define __USE_GNU
+#include <sched.h>
+#include <pthread.h>
+
+char *schedule_policy_names[] = {"static", "cyclic", "dynamic", "guided", "steal"};
+
+#define SCHEDULE_EMPTY -1
+#define SCHEDULE_ABORT -2
+
+/**
+ * Parse the test option 'policy[chunk]'. Returns false, if 'token' is
+ * not a scheduling policy
+ */
+bool schedule_parse(char *token, char *option, schedule_t *schedule) {
+	schedule_policy_t policy;
+	for(policy=0; policy<SCHEDULE_POLICY_COUNT; policy++) {
+		if(strcmp(token, schedule_policy_names[policy]) == 0) break;
+	}
+	if(policy == SCHEDULE_POLICY_COUNT) return false;
+	schedule->policy = policy;
+	schedule->chunk = SCHEDULE_DEFAULT_CHUNK;
+	if(option != NULL) {
+		schedule->chunk = strtoull(option, NULL, 10);
+		if(schedule->chunk == 0) {
+			_printf("WARNING: chunk size %s not valid, using %d\n", option, SCHEDULE_DEFAULT_CHUNK);
+			schedule->chunk = SCHEDULE_DEFAULT_CHUNK;
+		}
+	}
+	return true;
+}
+
+void schedule_append_name(char **str, schedule_t schedule) {
+	strappend(str, schedule_policy_names[schedule.policy]);
+	if(schedule.policy != SCHEDULE_STATIC) {
+		char chunk[32];
+		snprintf(chunk, sizeof(chunk), "[%Lu]", schedule.chunk);
+		strappend(str, chunk);
+	}
+}
+
+loop_schedule_t *loop_schedule_create(schedule_t schedule, void *(*loop_function)(void *),
+		unsigned_huge first, unsigned_huge last, unsigned num_threads) {
+	loop_schedule_t *loop = NULL;
+	if(posix_memalign((void **)&loop, THREAD_CACHE_LINE, sizeof(loop_schedule_t)) != 0) {
+		return NULL;
+	}
+	memset(loop, 0, sizeof(loop_schedule_t));
+	loop->schedule = schedule;
+	loop->loop_function = loop_function;
+	loop->first = first;
+	loop->last = last;
+	loop->num_threads = num_threads;
+	if(schedule.policy == SCHEDULE_STEAL) {
+		if(posix_memalign((void **)&loop->deques, THREAD_CACHE_LINE,
+				num_threads * sizeof(schedule_deque_t)) != 0) {
+			free(loop);
+			return NULL;
+		}
+		unsigned_huge chunks = (last - first + schedule.chunk - 1) / schedule.chunk;
+		unsigned i;
+		for(i=0; i<num_threads; i++) {
+			loop->deques[i].first = i * chunks / num_threads;
+			loop->deques[i].size = (i + 1) * chunks / num_threads - loop->deques[i].first;
+		}
+	}
+	loop_schedule_reset(loop);
+	return loop;
+}
+
+/**
+ * restore the initial distribution, before every run of the loop
+ */
+void loop_schedule_reset(loop_schedule_t *loop) {
+	loop->next = loop->first;
+	if(loop->deques != NULL) {
+		unsigned i;
+		for(i=0; i<loop->num_threads; i++) {
+			loop->deques[i].top = 0;
+			loop->deques[i].bottom = loop->deques[i].size;
+		}
+	}
+}
+
+void loop_schedule_free(loop_schedule_t *loop) {
+	if(loop == NULL) return;
+	free(loop->deques);
+	free(loop);
+}
+
+/**
+ * take the chunk at the bottom of the own deque
+ */
+long schedule_deque_pop(schedule_deque_t *deque) {
+	long bottom = deque->bottom - 1;
+	deque->bottom = bottom;
+	__sync_synchronize();
+	long top = deque->top;
+	if(top > bottom) {
+		deque->bottom = bottom + 1;
+		return SCHEDULE_EMPTY;
+	}
+	long chunk = deque->first + bottom;
+	if(top == bottom) {
+		// last chunk, race against the thieves
+		if(!__sync_bool_compare_and_swap(&deque->top, top, top + 1)) chunk = SCHEDULE_EMPTY;
+		deque->bottom = bottom + 1;
+	}
+	return chunk;
+}
+
+/**
+ * take the chunk at the top of another thread's deque
+ */
+long schedule_deque_steal(schedule_deque_t *deque) {
+	long top = deque->top;
+	__sync_synchronize();
+	long bottom = deque->bottom;
+	if(top >= bottom) return SCHEDULE_EMPTY;
+	long chunk = deque->first + top;
+	if(!__sync_bool_compare_and_swap(&deque->top, top, top + 1)) return SCHEDULE_ABORT;
+	return chunk;
+}
+
+/**
+ * Next iterations [*start, *end) of thread 'tid'. 'cyclic' is the next
+ * chunk of the thread for the cyclic policy. Returns false, if the loop
+ * is finished
+ */
+bool loop_schedule_next(loop_schedule_t *loop, unsigned tid, unsigned_huge *cyclic,
+		unsigned_huge *start, unsigned_huge *end) {
+	unsigned_huge chunk = loop->schedule.chunk;
+	switch(loop->schedule.policy) {
+	case SCHEDULE_CYCLIC:
+		*start = loop->first + *cyclic * chunk;
+		*cyclic += loop->num_threads;
+		break;
+	case SCHEDULE_DYNAMIC:
+		*start = __sync_fetch_and_add(&loop->next, chunk);
+		break;
+	case SCHEDULE_GUIDED:
+		while(true) {
+			*start = loop->next;
+			if(*start >= loop->last) return false;
+			unsigned_huge size = (loop->last - *start) / loop->num_threads;
+			size = size < chunk ? chunk : size;
+			*end = *start + size > loop->last ? loop->last : *start + size;
+			if(__sync_bool_compare_and_swap(&loop->next, *start, *end)) return true;
+		}
+	case SCHEDULE_STEAL: {
+		long id = schedule_deque_pop(&loop->deques[tid]);
+		unsigned i;
+		for(i=1; i<loop->num_threads && id < 0; i++) {
+			schedule_deque_t *victim = &loop->deques[(tid + i) % loop->num_threads];
+			do {
+				id = schedule_deque_steal(victim);
+			} while(id == SCHEDULE_ABORT);
+		}
+		if(id < 0) return false;
+		*start = loop->first + id * chunk;
+		break;
+	}
+	default:
+		return false;
+	}
+	if(*start >= loop->last) return false;
+	*end = *start + chunk > loop->last ? loop->last : *start + chunk;
+	return true;
+}
+
+/**
+ * loop function of the threads (arg->data is the loop_schedule_t): run the
+ * loop function of the schedule on every chunk and sum the results
+ */
+void *loop_schedule_function(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	loop_schedule_t *loop = (loop_schedule_t*) arg->data;
+	unsigned_huge cyclic = arg->tid, start, end;
+	huge result = 0;
+	while(loop_schedule_next(loop, arg->tid, &cyclic, &start, &end)) {
+		arg->iteration_start = start;
+		arg->iteration_end = end;
+		loop->loop_function(arg);
+		result += arg->result;
+	}
+	arg->result = result;
+	return (void *)NULL;
+}
@@ -0,0 +1,79 @@
+/*
+ * loop_schedule.h
+ *
+ * Distribution of loop iterations among the pool threads: static blocks,
+ * cyclic chunks, dynamic and guided self-scheduling and work stealing.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __LOOP_SCHEDULE_H
+#define __LOOP_SCHEDULE_H
+
+#include "definitions.h"
+#include "pthread_functions.h"
+
+typedef enum {
+	SCHEDULE_STATIC,	// one contiguous block per thread
+	SCHEDULE_CYCLIC,	// chunks dealt round robin
+	SCHEDULE_DYNAMIC,	// next chunk from a shared atomic counter
+	SCHEDULE_GUIDED,	// remaining iterations / threads, at least one chunk
+	SCHEDULE_STEAL,		// blocks of chunks in Chase-Lev deques, idle threads steal
+	SCHEDULE_POLICY_COUNT
+} schedule_policy_t;
+
+typedef struct {
+	schedule_policy_t policy;
+	unsigned_huge chunk;	// iterations, minimum for guided
+} schedule_t;
+
+#define SCHEDULE_DEFAULT_CHUNK 64
+#define SCHEDULE_T_INIT {SCHEDULE_STATIC, SCHEDULE_DEFAULT_CHUNK}
+
+/**
+ * work stealing deque of one thread. The deque holds the chunks
+ * first+top ... first+bottom-1, the owner takes from the bottom
+ */
+typedef struct {
+	volatile long top __attribute__((aligned(THREAD_CACHE_LINE)));
+	volatile long bottom __attribute__((aligned(THREAD_CACHE_LINE)));
+	long first;
+	long size;
+} __attribute__((aligned(THREAD_CACHE_LINE))) schedule_deque_t;
+
+typedef struct {
+	schedule_t schedule;
+	void *(*loop_function)(void *);
+	unsigned_huge first;	// iterations first ... last-1
+	unsigned_huge last;
+	unsigned num_threads;
+
+	volatile unsigned_huge next __attribute__((aligned(THREAD_CACHE_LINE)));
+	schedule_deque_t *deques;
+} loop_schedule_t;
+
+extern char *schedule_policy_names[];
+
+bool schedule_parse(char *token, char *option, schedule_t *schedule);
+void schedule_append_name(char **str, schedule_t schedule);
+
+loop_schedule_t *loop_schedule_create(schedule_t schedule, void *(*loop_function)(void *),
+		unsigned_huge first, unsigned_huge last, unsigned num_threads);
+void loop_schedule_reset(loop_schedule_t *loop);
+void loop_schedule_free(loop_schedule_t *loop);
+void *loop_schedule_function(void *arg);
+
+#endif
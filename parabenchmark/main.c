@@ -31,6 +31,14 @@
 #include "memory_benchmark.h"
 #include "pthread_benchmark.h"
 #include "speedup_benchmark.h"
+#include "memcpy_benchmark.h"
+#include "coherence_benchmark.h"
+#include "memory_loaded.h"
+#include "io_benchmark.h"
+#include "malloc_benchmark.h"
+#include "matrix_benchmark.h"
+#include "sync_benchmark.h"
+#include "lock_benchmark.h"
 #ifdef COMPILE_WITH_MPI
 #include "mpi_functions.h"
 #include "mpi_benchmark.h"
@@ -68,9 +76,27 @@ typedef enum {
 	OPT_RANGE = 'x',
 	OPT_BLOCKSIZE = 'b',
 	OPT_STRIDE = 'u',
+	OPT_CHAINS = 'k',
+	OPT_DISTANCE = 'D',
+	OPT_WIDTH = 'W',
+	OPT_SRC_OFFSET = 'S',
+	OPT_DST_OFFSET = 'T',
+	OPT_OVERLAP = 'O',
+	OPT_CACHE_STATE = 'C',
+	OPT_IO_FILE = 'F',
+	OPT_IO_FILE_SIZE = 'Z',
+	OPT_IO_BLOCKSIZE = 'B',
+	OPT_QUEUE_DEPTH = 'Q',
+	OPT_CRITICAL_SECTION = 'L',
+	OPT_THINK_TIME = 'I',
+	OPT_READ_RATIO = 'R',
+	OPT_ALLOC = 'm',
+	OPT_NUMA = 'N',
+	OPT_DETECT_CACHE = 'c',
 
 	OPT_WARMUP = 'w',
 	OPT_THREAD_AFFINITY = 'a',
+	OPT_THREAD_DISPATCH = 'P',
 
 	OPT_EXECUTE_TEST = 'e',
 	OPT_LIST_TESTS = 'l'
@@ -93,7 +119,9 @@ option_info_t option_infos[] = {
 	{OPT_RANGE, "general range (can be data size/iterations, dependent on selected benchmark)",
 			"range", "range[,range...]", required_argument, 0, false},
 	{OPT_THREAD_AFFINITY, "thread affinity (default: roundrobin)",
-			"thread-affinity", "none|roundrobin", required_argument, 0, true},
+			"thread-affinity", "none|roundrobin", required_argument, 0, false},
+	{OPT_THREAD_DISPATCH, "start of the pool threads (default: condvar; spin time in microseconds, default 50)",
+			"thread-dispatch", "condvar|spin[us]", required_argument, 0, true},
 
 	{OPT_REPETITIONS, "the program tries to use only 'arg' seconds for ALL repetitions",
 			"repetitions", "min[float],time[float]", required_argument, 0, false},
@@ -107,6 +135,40 @@ option_info_t option_infos[] = {
 			"blocksize", "range[,range...]", required_argument, 0, false},
 	{OPT_STRIDE, "stride for memory benchmark",
 			"stride", "range[,range...]", required_argument, 0, false},
+	{OPT_CHAINS, "number of concurrent pointer chains for memory benchmark (mlp)",
+			"chains", "range[,range...]", required_argument, 0, false},
+	{OPT_DISTANCE, "software prefetch distance (in accesses) for memory benchmark",
+			"distance", "range[,range...]", required_argument, 0, false},
+	{OPT_WIDTH, "access width in bytes (1, 2, 4, 8, 16, 32, 64) for memory benchmark",
+			"width", "range[,range...]", required_argument, 0, false},
+	{OPT_SRC_OFFSET, "source offset from a page boundary for memcpy benchmark",
+			"src-offset", "range[,range...]", required_argument, 0, false},
+	{OPT_DST_OFFSET, "destination offset from a page boundary for memcpy benchmark",
+			"dst-offset", "range[,range...]", required_argument, 0, false},
+	{OPT_OVERLAP, "bytes of overlap between source and destination for memcpy benchmark (memmove only)",
+			"overlap", "range[,range...]", required_argument, 0, false},
+	{OPT_ALLOC, "buffer allocation for memory benchmark: malloc, populate, thp, hugetlb2m, hugetlb1g (default: malloc)",
+			"alloc", "backend", required_argument, 0, false},
+	{OPT_NUMA, "numa placement for memory benchmark: firsttouch, local, interleave, bind[node], matrix (default: firsttouch)",
+			"numa", "policy", required_argument, 0, false},
+	{OPT_CACHE_STATE, "cache state before every repetition of the memory benchmark (default: evict)",
+			"cache-state", "warm|flush|evict|full", required_argument, 0, false},
+	{OPT_IO_FILE, "scratch file for io benchmark, must not exist (default: parabenchmark.io)",
+			"io-file", "path", required_argument, 0, false},
+	{OPT_IO_FILE_SIZE, "size of the scratch file in bytes for io benchmark (default: 268435456)",
+			"io-file-size", "int", required_argument, 0, false},
+	{OPT_IO_BLOCKSIZE, "request size in bytes for io benchmark",
+			"io-blocksize", "range[,range...]", required_argument, 0, false},
+	{OPT_QUEUE_DEPTH, "requests in flight for io benchmark (aio, uring)",
+			"queue-depth", "range[,range...]", required_argument, 0, false},
+	{OPT_CRITICAL_SECTION, "work units inside the critical section for lock benchmark",
+			"critical-section", "range[,range...]", required_argument, 0, false},
+	{OPT_THINK_TIME, "work units between two acquisitions for lock benchmark",
+			"think-time", "range[,range...]", required_argument, 0, false},
+	{OPT_READ_RATIO, "percentage of read acquisitions for lock benchmark (rwlock)",
+			"read-ratio", "range[,range...]", required_argument, 0, false},
+	{OPT_DETECT_CACHE, "infer cache levels from memory benchmark range sweep and refine it (default: false)",
+			"detect-cache", "true|false", optional_argument, 0, false},
 
 	{OPT_OUTPUT_TEE, "benchmark output also on screen when writing to files (default: true)",
 				"output-tee", "true|false", optional_argument, 0, false},
@@ -136,11 +198,21 @@ typedef struct test_t_ {
 } test_t;
 
 test_t tests[] = {
-		{"memory-bandwidth", &start_memory_bandwidth_benchmark, ""}, // TODO: Test description
+		{"memory-bandwidth", &start_memory_bandwidth_benchmark, "option (list): access functions; single, private, shared"},
+		{"loaded-latency", &start_loaded_latency_benchmark, "option (list): load access functions of memory-bandwidth"},
 		{"pthread-create", &start_pthread_create_benchmark, ""}, // TODO: Test description
-		{"pthread-loop", &start_pthread_loop_benchmark, "option (list): int, float"},
-		{"speedup", &start_speedup_benchmark, "option (list): int, float"},
-		{"compensation-point", &start_compensation_point_benchmark, "option (list): int, float"},
+		{"pthread-loop", &start_pthread_loop_benchmark, "option (list): int, float, linear, random; reduce[condvar|atomic|slots|spin-tree|dissemination], noreduce; static, cyclic[chunk], dynamic[chunk], guided[chunk], steal[chunk]"},
+		{"speedup", &start_speedup_benchmark, "option (list): int, float, linear, random; reduce[condvar|atomic|slots|spin-tree|dissemination], noreduce; static, cyclic[chunk], dynamic[chunk], guided[chunk], steal[chunk]"},
+		{"compensation-point", &start_compensation_point_benchmark, "option (list): int, float, linear, random; reduce[strategy], noreduce; static, cyclic[chunk], dynamic[chunk], guided[chunk], steal[chunk]"},
+		{"sync", &start_sync_benchmark, "option (list): condvar, pthread-barrier, futex, spin, dissemination; all"},
+		{"lock", &start_lock_benchmark, "option (list): mutex, mutex-adaptive, spinlock, ticket, mcs, rwlock; all"},
+		{"atomics", &start_atomics_benchmark, "option (list): shared, padded, xadd, cmpxchg, xchg, relaxed, seqcst"},
+		{"core-to-core", &start_core_to_core_benchmark, ""},
+		{"false-sharing", &start_false_sharing_benchmark, "option (list): plain, atomic, counter distances in bytes; all"},
+		{"memcpy", &start_memcpy_benchmark, "option (list): memcpy, memmove, memset, movsb, stosb, sse2, avx2, avx512, nt; copy, set, all"},
+		{"transpose", &start_matrix_benchmark, "option (list): transpose, transpose-blocked, transpose-oblivious, copy, copy-tiled; all"},
+		{"malloc", &start_malloc_benchmark, "option (list): lifo, fifo, random; local, remote; sizes in bytes; all"},
+		{"io-bandwidth", &start_io_benchmark, "option (list): pread, direct, mmap, aio, uring; seqread, randread, seqwrite, randwrite; read, write, all"},
 #ifdef COMPILE_WITH_MPI
 		{"mpi-bandwidth", &start_mpi_bandwidth_benchmark, ""},
 #endif
@@ -168,6 +240,8 @@ int main (int argc, char **argv) {
 	default_config.output_omit_startup_system_info = false;
 
 	default_config.thread_affinity = AFFINITY_ROUND_ROBIN;
+	default_config.thread_dispatch = DISPATCH_CONDVAR;
+	default_config.dispatch_spin_time = 50e-6;
 	default_config.warmup = 1;
 	//default_config.steps.time_guide_value = 0.06;
 	//default_config.repetitions.time_guide_value = 1;
@@ -181,8 +255,26 @@ int main (int argc, char **argv) {
 	default_config.range = parse_range_option("1-10000000000[*2]");
 	default_config.memory.stride = parse_range_option("1-512[*2]");
 	default_config.memory.blocksize = parse_range_option("1-512[*2]");
+	default_config.memory.chains = parse_range_option("1-16[+1]");
+	default_config.memory.distance = parse_range_option("0,1-256[*2]");
+	default_config.memory.width = parse_range_option("1-64[*2]");
+	default_config.copy.src_offset = parse_range_option("0");
+	default_config.copy.dst_offset = parse_range_option("0");
+	default_config.copy.overlap = parse_range_option("0");
+	default_config.io.blocksize = parse_range_option("4096-1048576[*4]");
+	default_config.io.queue_depth = parse_range_option("1-64[*4]");
+	default_config.io.file = "parabenchmark.io";
+	default_config.io.file_size = 256*MB;
+	default_config.lock.critical_section = parse_range_option("10-1000[*10]");
+	default_config.lock.think_time = parse_range_option("0");
+	default_config.lock.read_ratio = parse_range_option("0,50,90");
 
 	default_config.memory.cache_clean_size = 8*MB;
+	default_config.memory.alloc = ALLOC_MALLOC;
+	default_config.memory.numa = NUMA_FIRST_TOUCH;
+	default_config.memory.numa_node = 0;
+	default_config.memory.detect_cache = false;
+	default_config.memory.cache_state = CACHE_STATE_EVICT;
 
 	// process command line options
     int c;
@@ -245,6 +337,58 @@ int main (int argc, char **argv) {
         	default_config.memory.stride = parse_range_option(optarg);
         	break;
 
+        case OPT_CHAINS:
+        	default_config.memory.chains = parse_range_option(optarg);
+        	break;
+
+        case OPT_DISTANCE:
+        	default_config.memory.distance = parse_range_option(optarg);
+        	break;
+
+        case OPT_WIDTH:
+        	default_config.memory.width = parse_range_option(optarg);
+        	break;
+
+        case OPT_SRC_OFFSET:
+        	default_config.copy.src_offset = parse_range_option(optarg);
+        	break;
+
+        case OPT_DST_OFFSET:
+        	default_config.copy.dst_offset = parse_range_option(optarg);
+        	break;
+
+        case OPT_OVERLAP:
+        	default_config.copy.overlap = parse_range_option(optarg);
+        	break;
+
+        case OPT_IO_FILE:
+        	default_config.io.file = optarg;
+        	break;
+
+        case OPT_IO_FILE_SIZE:
+        	default_config.io.file_size = strtoull(optarg, NULL, 10);
+        	break;
+
+        case OPT_IO_BLOCKSIZE:
+        	default_config.io.blocksize = parse_range_option(optarg);
+        	break;
+
+        case OPT_QUEUE_DEPTH:
+        	default_config.io.queue_depth = parse_range_option(optarg);
+        	break;
+
+        case OPT_CRITICAL_SECTION:
+        	default_config.lock.critical_section = parse_range_option(optarg);
+        	break;
+
+        case OPT_THINK_TIME:
+        	default_config.lock.think_time = parse_range_option(optarg);
+        	break;
+
+        case OPT_READ_RATIO:
+        	default_config.lock.read_ratio = parse_range_option(optarg);
+        	break;
+
         case OPT_REPETITIONS: {
         	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
 			char *option, *token;
@@ -310,10 +454,108 @@ int main (int argc, char **argv) {
         	break;
         }
 
+        case OPT_THREAD_DISPATCH: {
+        	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
+			char *option, *token;
+			while((token = get_token(&get_token_pointers, optarg, &option)) != NULL) {
+				if(strcmp(token, "condvar") == 0) {
+					default_config.thread_dispatch = DISPATCH_CONDVAR;
+				}
+				else if(strcmp(token, "spin") == 0) {
+					default_config.thread_dispatch = DISPATCH_SPIN;
+					if(option != NULL) default_config.dispatch_spin_time = atof(option) * 1e-6;
+				}
+				else {
+					_printf("WARNING: thread dispatch option %s not valid\n", token);
+				}
+			}
+        	break;
+        }
+
+        case OPT_ALLOC: {
+        	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
+			char *option, *token;
+			while((token = get_token(&get_token_pointers, optarg, &option)) != NULL) {
+				if(strcmp(token, "malloc") == 0) {
+					default_config.memory.alloc = ALLOC_MALLOC;
+				}
+				else if(strcmp(token, "populate") == 0) {
+					default_config.memory.alloc = ALLOC_POPULATE;
+				}
+				else if(strcmp(token, "thp") == 0) {
+					default_config.memory.alloc = ALLOC_THP;
+				}
+				else if(strcmp(token, "hugetlb2m") == 0) {
+					default_config.memory.alloc = ALLOC_HUGETLB_2M;
+				}
+				else if(strcmp(token, "hugetlb1g") == 0) {
+					default_config.memory.alloc = ALLOC_HUGETLB_1G;
+				}
+				else {
+					_printf("WARNING: alloc option %s not valid\n", token);
+				}
+			}
+        	break;
+        }
+
+        case OPT_CACHE_STATE: {
+        	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
+			char *option, *token;
+			while((token = get_token(&get_token_pointers, optarg, &option)) != NULL) {
+				if(strcmp(token, "warm") == 0) {
+					default_config.memory.cache_state = CACHE_STATE_WARM;
+				}
+				else if(strcmp(token, "flush") == 0) {
+					default_config.memory.cache_state = CACHE_STATE_FLUSH;
+				}
+				else if(strcmp(token, "evict") == 0) {
+					default_config.memory.cache_state = CACHE_STATE_EVICT;
+				}
+				else if(strcmp(token, "full") == 0) {
+					default_config.memory.cache_state = CACHE_STATE_FULL;
+				}
+				else {
+					_printf("WARNING: cache state option %s not valid\n", token);
+				}
+			}
+        	break;
+        }
+
+        case OPT_NUMA: {
+        	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
+			char *option, *token;
+			while((token = get_token(&get_token_pointers, optarg, &option)) != NULL) {
+				if(strcmp(token, "firsttouch") == 0) {
+					default_config.memory.numa = NUMA_FIRST_TOUCH;
+				}
+				else if(strcmp(token, "local") == 0) {
+					default_config.memory.numa = NUMA_LOCAL;
+				}
+				else if(strcmp(token, "interleave") == 0) {
+					default_config.memory.numa = NUMA_INTERLEAVE;
+				}
+				else if(strcmp(token, "bind") == 0) {
+					default_config.memory.numa = NUMA_BIND;
+					default_config.memory.numa_node = option != NULL ? atoi(option) : 0;
+				}
+				else if(strcmp(token, "matrix") == 0) {
+					default_config.memory.numa = NUMA_MATRIX;
+				}
+				else {
+					_printf("WARNING: numa option %s not valid\n", token);
+				}
+			}
+        	break;
+        }
+
         case OPT_WARMUP:
         	default_config.warmup =  atoi(optarg);
         	break;
 
+        case OPT_DETECT_CACHE:
+        	parse_bool_option("detect cache", optarg, &default_config.memory.detect_cache, true);
+        	break;
+
         case OPT_OUTPUT_TEE:
         	parse_bool_option("output tee", optarg, &default_config.output_tee, true);
         	break;
@@ -0,0 +1,367 @@
+/*
+ * malloc_benchmark.c
+ *
+ * Allocator throughput and scalability: alloc/free storms of all threads
+ * with different size classes, free orders and freeing threads.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "malloc_benchmark.h"
+#include "memory_benchmark.h"
+#include "pthread_functions.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+
+#include <unistd.h>
+#define __USE_GNU
+#include <dlfcn.h>
+#include <pthread.h>
+
+extern config_t config;
+
+typedef enum {
+	MALLOC_FREE_LIFO,	// reverse allocation order
+	MALLOC_FREE_FIFO,	// allocation order
+	MALLOC_FREE_RANDOM,	// random permutation
+	MALLOC_ORDER_COUNT
+} malloc_order_t;
+
+char *malloc_order_names[] = {"lifo", "fifo", "random"};
+
+typedef enum {
+	MALLOC_LOCAL,		// every thread frees its own objects
+	MALLOC_REMOTE,		// thread i frees the objects of thread i-1 (producer/consumer)
+	MALLOC_MODE_COUNT
+} malloc_mode_t;
+
+char *malloc_mode_names[] = {"local", "remote"};
+
+typedef struct malloc_thread_data_t_ malloc_thread_data_t;
+
+struct malloc_thread_data_t_ {
+	size_t size;
+	unsigned_huge objects;		// allocations per thread and repetition
+	void **object;				// allocated by this thread
+	unsigned_huge *order;		// free order (index into object)
+	malloc_thread_data_t *producer;	// thread, whose objects are freed
+	pthread_barrier_t *barrier;	// between allocation and free phase (remote only)
+
+	double *malloc_latency;		// NULL, if single operations are not timed
+	double *free_latency;
+};
+
+/**
+ * file name of the library, which provides malloc (LD_PRELOAD is respected)
+ */
+char *malloc_allocator_name() {
+	static char *name = NULL;
+	if(name != NULL) return name;
+	Dl_info info;
+	void *fn = dlsym(RTLD_DEFAULT, "malloc");
+	if(fn == NULL || dladdr(fn, &info) == 0 || info.dli_fname == NULL) {
+		name = "unknown";
+		return name;
+	}
+	name = strrchr(info.dli_fname, '/');
+	name = name == NULL ? (char *)info.dli_fname : name + 1;
+	return name;
+}
+
+/**
+ * resident set size of the process in bytes
+ */
+unsigned_huge malloc_rss() {
+	unsigned_huge size = 0, resident = 0;
+	FILE *file = fopen("/proc/self/statm", "r");
+	if(file == NULL) return 0;
+	if(fscanf(file, "%Lu %Lu", &size, &resident) != 2) resident = 0;
+	fclose(file);
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * Allocate all objects, then free the objects of the producer. The first
+ * byte of each object is written. The time excludes the barrier
+ */
+void *malloc_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	malloc_thread_data_t *data = (malloc_thread_data_t*) arg->data;
+	unsigned_huge i, n = data->objects;
+	size_t size = data->size;
+	void **object = data->object;
+	double tmp, time;
+	timespec_t op;
+
+	tick2(MODE_START, &tmp);
+	if(data->malloc_latency == NULL) {
+		for(i=0; i<n; i++) {
+			object[i] = malloc(size);
+			*(volatile char *)object[i] = 1;
+		}
+	}
+	else {
+		for(i=0; i<n; i++) {
+			tick_precise(MODE_START, &op);
+			object[i] = malloc(size);
+			*(volatile char *)object[i] = 1;
+			data->malloc_latency[i] = tick_precise(MODE_END, &op);
+		}
+	}
+	time = tick2(MODE_END, &tmp);
+
+	if(data->barrier != NULL) pthread_barrier_wait(data->barrier);
+
+	object = data->producer->object;
+	unsigned_huge *order = data->order;
+	tick2(MODE_START, &tmp);
+	if(data->free_latency == NULL) {
+		for(i=0; i<n; i++) free(object[order[i]]);
+	}
+	else {
+		for(i=0; i<n; i++) {
+			tick_precise(MODE_START, &op);
+			free(object[order[i]]);
+			data->free_latency[i] = tick_precise(MODE_END, &op);
+		}
+	}
+	arg->time = time + tick2(MODE_END, &tmp);
+	return (void *)NULL;
+}
+
+void malloc_fill_order(unsigned_huge *order, unsigned_huge n, malloc_order_t free_order, unsigned seed) {
+	unsigned_huge i, random = seed;
+	for(i=0; i<n; i++) {
+		order[i] = free_order == MALLOC_FREE_LIFO ? n - 1 - i : i;
+	}
+	if(free_order != MALLOC_FREE_RANDOM) return;
+	for(i=n; i>1; i--) {
+		random = random * RANDOM_A + RANDOM_C;
+		unsigned_huge j = (random >> 16) % i;
+		unsigned_huge swap = order[i-1]; order[i-1] = order[j]; order[j] = swap;
+	}
+}
+
+/**
+ * Every thread allocates 'config.steps.number' objects of 'size' bytes and
+ * frees them (or those of its neighbor) in the given order. The first half
+ * of the repetitions measures the throughput, the second half the latency
+ * of the single operations
+ */
+void malloc_test(unsigned num_threads, size_t size, malloc_order_t free_order, malloc_mode_t mode) {
+	if(num_threads == 0 || size == 0) return;
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL) {
+		_printf("Cannot allocate enough space for threads\n");
+		return;
+	}
+	unsigned_huge objects = config.steps.number;
+	unsigned_huge repetitions = config.repetitions.number;
+	unsigned_huge samples = num_threads * repetitions * objects;
+	double *malloc_latency = (double*)malloc(samples * sizeof(double));
+	double *free_latency = (double*)malloc(samples * sizeof(double));
+	double *time_single = (double*)malloc((repetitions+1)*sizeof(double));
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, num_threads);
+	malloc_thread_data_t data[num_threads];
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		data[i].size = size;
+		data[i].objects = objects;
+		data[i].object = (void **)malloc(objects * sizeof(void *));
+		data[i].order = (unsigned_huge *)malloc(objects * sizeof(unsigned_huge));
+		malloc_fill_order(data[i].order, objects, free_order, i + 1);
+		data[i].producer = mode == MALLOC_REMOTE ? &data[(i + num_threads - 1) % num_threads] : &data[i];
+		data[i].barrier = mode == MALLOC_REMOTE ? &barrier : NULL;
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &malloc_loop;
+		args[i].data = &data[i];
+	}
+
+	unsigned_huge rss_before = malloc_rss();
+	int r;
+	for(r=-config.warmup; r<2*(int)repetitions; r++) {
+		bool timed = r >= (int)repetitions;
+		for(i=0; i<num_threads; i++) {
+			unsigned_huge offset = ((r - repetitions) * num_threads + i) * objects;
+			data[i].malloc_latency = timed ? malloc_latency + offset : NULL;
+			data[i].free_latency = timed ? free_latency + offset : NULL;
+		}
+		threads_prepare(args, num_threads);
+		threads_start(args, num_threads);
+		threads_join(args, num_threads);
+		if(r < 0 || timed) continue;
+
+		double sum = 0;
+		for(i=0; i<num_threads; i++) sum += args[i].time;
+		time_single[r] = sum / num_threads;
+	}
+	unsigned_huge rss_after = malloc_rss();
+	statistic_t stat = middle_stat(time_single, repetitions);
+
+	double per_thread = 2 * objects / stat.mean / 1e6;
+	print_table_cell("%{threads}5u, ", num_threads);
+	print_table_cell("%{size}8Lu, ", (unsigned_huge)size);
+	print_table_cell("%{objects per thread}8Lu, ", objects);
+	print_table_cell("%{repetitions}6Lu, ", repetitions);
+	print_table_cell("%{mega ops per second per thread}" PRECISSION "f, ", per_thread);
+	print_table_cell("%{total}" PRECISSION "f, ", per_thread * num_threads);
+	print_table_cell("%{malloc p50 ns}" PRECISSION "f, ", percentile(malloc_latency, samples, 0.5) * 1e9);
+	print_table_cell("%{malloc p99 ns}" PRECISSION "f, ", percentile(malloc_latency, samples, 0.99) * 1e9);
+	print_table_cell("%{malloc p99.9 ns}" PRECISSION "f, ", percentile(malloc_latency, samples, 0.999) * 1e9);
+	print_table_cell("%{free p50 ns}" PRECISSION "f, ", percentile(free_latency, samples, 0.5) * 1e9);
+	print_table_cell("%{free p99 ns}" PRECISSION "f, ", percentile(free_latency, samples, 0.99) * 1e9);
+	print_table_cell("%{free p99.9 ns}" PRECISSION "f, ", percentile(free_latency, samples, 0.999) * 1e9);
+	print_table_cell("%{rss growth KiB}10lld, ", ((huge)rss_after - (huge)rss_before) / KB);
+	print_table_line();
+
+	for(i=0; i<num_threads; i++) {
+		free(data[i].object);
+		free(data[i].order);
+	}
+	pthread_barrier_destroy(&barrier);
+	free(malloc_latency);
+	free(free_latency);
+	free(time_single);
+}
+
+void start_malloc_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("malloc benchmark\n");
+	_printf("allocator: %s\n", malloc_allocator_name());
+	_printf("every thread allocates 'steps' objects (first byte written) and frees them in the given order\n");
+	_printf("remote: every thread frees the objects of its neighbor, after all threads allocated\n");
+	_printf("throughput in mega operations (malloc or free) per second, latency of single operations in ns\n");
+	_printf("rss growth: resident set size after minus before the test point\n");
+	_printf("###############\n");
+
+	if(option == NULL) option = "all";
+
+	// free orders, modes and sizes (numbers) of the option
+	bool orders[MALLOC_ORDER_COUNT], modes[MALLOC_MODE_COUNT];
+	memset(orders, 0, sizeof(orders));
+	memset(modes, 0, sizeof(modes));
+	char *size_list = NULL;
+	unsigned option_count, i, j;
+	char **options = get_token_array(option, &option_count);
+	for(i=0; i<option_count; i++) {
+		bool found = false;
+		bool all = strcmp(options[i], "all") == 0;
+		for(j=0; j<MALLOC_ORDER_COUNT; j++) {
+			if(all || strcmp(options[i], malloc_order_names[j]) == 0) orders[j] = found = true;
+		}
+		for(j=0; j<MALLOC_MODE_COUNT; j++) {
+			if(all || strcmp(options[i], malloc_mode_names[j]) == 0) modes[j] = found = true;
+		}
+		if(!found && atoll(options[i]) > 0) {
+			if(size_list != NULL) strappend(&size_list, ",");
+			strappend(&size_list, options[i]);
+			found = true;
+		}
+		if(!found) {
+			_printf("WARNING: unknown option for malloc benchmark: %s\n", options[i]);
+		}
+	}
+	unsigned selected_orders = 0, selected_modes = 0;
+	for(j=0; j<MALLOC_ORDER_COUNT; j++) selected_orders += orders[j];
+	for(j=0; j<MALLOC_MODE_COUNT; j++) selected_modes += modes[j];
+	if(selected_orders == 0) memset(orders, 1, sizeof(orders));
+	if(selected_modes == 0) memset(modes, 1, sizeof(modes));
+	range_t *sizes = parse_range_option(size_list != NULL ? size_list : "16-1048576[*4]");
+
+	get_thread_array(config.threads->end);
+
+	malloc_order_t free_order = MALLOC_FREE_LIFO;
+	malloc_mode_t mode = MALLOC_LOCAL;
+	char *additional_info = NULL;
+
+	int set_order_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_order;
+		get_iteration_value("order", level, vec, &num_order);
+		if(num_order >= MALLOC_ORDER_COUNT) return NESTED_FOR_BREAK;
+		if(!orders[num_order]) return NESTED_FOR_CONT;
+		free_order = num_order;
+		return 0;
+	}
+
+	int set_mode_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_mode;
+		get_iteration_value("mode", level, vec, &num_mode);
+		if(num_mode >= MALLOC_MODE_COUNT) return NESTED_FOR_BREAK;
+		if(!modes[num_mode]) return NESTED_FOR_CONT;
+		mode = num_mode;
+		free(additional_info);
+		additional_info = NULL;
+		strappend(&additional_info, malloc_order_names[free_order]);
+		strappend(&additional_info, ", ");
+		strappend(&additional_info, malloc_mode_names[mode]);
+		strappend(&additional_info, ", ");
+		strappend(&additional_info, malloc_allocator_name());
+		print_table_set_additional_info("free order, free thread, allocator", additional_info);
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge size; get_iteration_value("size", level, vec, &size);
+		unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
+		// with one thread, remote is the same as local
+		if(mode == MALLOC_REMOTE && num_threads < 2) return 0;
+		malloc_test(num_threads, size, free_order, mode);
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t order_loop = FOR_LOOP_T_INIT;
+	order_loop.var.name = "order";
+	order_loop.var.start = 0;
+	order_loop.var.end = MALLOC_ORDER_COUNT;
+	order_loop.step_fn = &step_increment;
+	order_loop.inner_start_fn = &set_order_fn;
+
+	for_loop_t mode_loop = FOR_LOOP_T_INIT;
+	mode_loop.var.name = "mode";
+	mode_loop.var.start = 0;
+	mode_loop.var.end = MALLOC_MODE_COUNT;
+	mode_loop.step_fn = &step_increment;
+	mode_loop.inner_start_fn = &set_mode_fn;
+
+	for_loop_t size_loop = FOR_LOOP_T_INIT;
+	size_loop.var.name = "size";
+	size_loop.var.range = sizes;
+	size_loop.step_fn = &step_range;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+
+	order_loop.next = &mode_loop;
+	mode_loop.next = &size_loop;
+	size_loop.next = &thread_loop;
+
+	nested_for_loop(&order_loop, fn);
+	range_free(sizes);
+	free(size_list);
+	free(additional_info);
+}
@@ -0,0 +1,31 @@
+/*
+ * malloc_benchmark.h
+ *
+ * Allocator throughput and scalability: alloc/free storms of all threads
+ * with different size classes, free orders and freeing threads.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MALLOC_BENCHMARK_H
+#define __MALLOC_BENCHMARK_H
+
+#include "definitions.h"
+
+char *malloc_allocator_name();
+void start_malloc_benchmark(char *option);
+
+#endif
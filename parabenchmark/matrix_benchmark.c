@@ -0,0 +1,328 @@
+/*
+ * matrix_benchmark.c
+ *
+ * 2D access patterns: naive, cache blocked and cache oblivious matrix
+ * transpose and row wise and tiled matrix copy.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "matrix_benchmark.h"
+#include "memory_benchmark.h"
+#include "memory_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+
+extern config_t config;
+
+/**
+ * edge length (in elements) below which the cache oblivious transpose
+ * stops the recursion
+ */
+#define MATRIX_OBLIVIOUS_BASE 16
+
+/**
+ * n x n matrices of doubles, row major
+ */
+typedef void (*matrix_fn_t)(double *dst, double *src, unsigned_huge n, unsigned_huge tile);
+
+/**
+ * sweep dimensions, which are used by a matrix function
+ */
+#define MATRIX_USES_TILE	0x01
+
+typedef struct {
+	char *name;
+	matrix_fn_t matrix_fn;
+	unsigned uses;
+} matrix_option_info_t;
+
+/**
+ * Copy 'count' consecutive doubles from 'src' to 'dst', the destination
+ * advances 'dst_stride' bytes per element (8: contiguous copy)
+ */
+void matrix_row(double *dst, double *src, unsigned_huge count, unsigned_huge dst_stride) {
+	if(count == 0) return;
+	__asm__ __volatile__ (
+		"1:"
+		"movq (%[src]), %%rax;"
+		"movq %%rax, (%[dst]);"
+		"add $8, %[src];"
+		"add %[stride], %[dst];"
+		"dec %[count];"
+		"jnz 1b;"
+		: [src] "+r" (src), [dst] "+r" (dst), [count] "+r" (count)
+		: [stride] "r" (dst_stride)
+		: "rax", "cc", "memory"
+	);
+}
+
+/**
+ * dst[j][i] = src[i][j] for the rows 'row' to 'row + rows' and the columns
+ * 'col' to 'col + cols'
+ */
+void matrix_transpose_block(double *dst, double *src, unsigned_huge n,
+		unsigned_huge row, unsigned_huge rows, unsigned_huge col, unsigned_huge cols) {
+	unsigned_huge i;
+	for(i=row; i<row+rows; i++) {
+		matrix_row(dst + col*n + i, src + i*n + col, cols, n*sizeof(double));
+	}
+}
+
+void matrix_transpose_naive(double *dst, double *src, unsigned_huge n, unsigned_huge tile) {
+	(void)tile;
+	matrix_transpose_block(dst, src, n, 0, n, 0, n);
+}
+
+void matrix_transpose_blocked(double *dst, double *src, unsigned_huge n, unsigned_huge tile) {
+	unsigned_huge i, j;
+	for(i=0; i<n; i+=tile) {
+		for(j=0; j<n; j+=tile) {
+			matrix_transpose_block(dst, src, n, i, i+tile < n ? tile : n-i, j, j+tile < n ? tile : n-j);
+		}
+	}
+}
+
+/**
+ * split the longer side until the block fits (into any cache)
+ */
+void matrix_transpose_recursive(double *dst, double *src, unsigned_huge n,
+		unsigned_huge row, unsigned_huge rows, unsigned_huge col, unsigned_huge cols) {
+	if(rows <= MATRIX_OBLIVIOUS_BASE && cols <= MATRIX_OBLIVIOUS_BASE) {
+		matrix_transpose_block(dst, src, n, row, rows, col, cols);
+	}
+	else if(rows >= cols) {
+		matrix_transpose_recursive(dst, src, n, row, rows/2, col, cols);
+		matrix_transpose_recursive(dst, src, n, row + rows/2, rows - rows/2, col, cols);
+	}
+	else {
+		matrix_transpose_recursive(dst, src, n, row, rows, col, cols/2);
+		matrix_transpose_recursive(dst, src, n, row, rows, col + cols/2, cols - cols/2);
+	}
+}
+
+void matrix_transpose_oblivious(double *dst, double *src, unsigned_huge n, unsigned_huge tile) {
+	(void)tile;
+	matrix_transpose_recursive(dst, src, n, 0, n, 0, n);
+}
+
+void matrix_copy_rows(double *dst, double *src, unsigned_huge n, unsigned_huge tile) {
+	(void)tile;
+	unsigned_huge i;
+	for(i=0; i<n; i++) {
+		matrix_row(dst + i*n, src + i*n, n, sizeof(double));
+	}
+}
+
+void matrix_copy_tiled(double *dst, double *src, unsigned_huge n, unsigned_huge tile) {
+	unsigned_huge i, j, k;
+	for(i=0; i<n; i+=tile) {
+		for(j=0; j<n; j+=tile) {
+			unsigned_huge cols = j+tile < n ? tile : n-j;
+			for(k=i; k<i+tile && k<n; k++) {
+				matrix_row(dst + k*n + j, src + k*n + j, cols, sizeof(double));
+			}
+		}
+	}
+}
+
+matrix_option_info_t matrix_option_infos[] = {
+		{"transpose", &matrix_transpose_naive, 0},
+		{"transpose-blocked", &matrix_transpose_blocked, MATRIX_USES_TILE},
+		{"transpose-oblivious", &matrix_transpose_oblivious, 0},
+		{"copy", &matrix_copy_rows, 0},
+		{"copy-tiled", &matrix_copy_tiled, MATRIX_USES_TILE},
+		{NULL, NULL, 0}
+};
+
+memory_buffer_t matrix_buffer = MEMORY_BUFFER_T_INIT;
+
+/**
+ * source and destination start at a page boundary
+ */
+bool matrix_buffers(unsigned_huge n, double **src, double **dst) {
+	unsigned_huge page = 4096;
+	unsigned_huge region = (n*n*sizeof(double) + page - 1) / page * page;
+	if(2*region + page > max_malloc_arg()) return false;
+	char *buffer = (char *)memory_buffer_get(&matrix_buffer, 2*region + page, 1, -1);
+	if(buffer == NULL) return false;
+	char *base = (char *)(((uintptr_t)buffer + page - 1) & ~((uintptr_t)page - 1));
+	*src = (double *)base;
+	*dst = (double *)(base + region);
+	return true;
+}
+
+/**
+ * calls per time measurement
+ */
+unsigned_huge matrix_calculate_steps(matrix_fn_t matrix_fn, double *dst, double *src,
+		unsigned_huge n, unsigned_huge tile) {
+	if(config.steps.time_guide_value == 0) return config.steps.number;
+	unsigned_huge steps = config.steps.min > 0 ? config.steps.min : 1;
+	while(true) {
+		unsigned_huge i;
+		tick(MODE_START);
+		for(i=0; i<steps; i++) matrix_fn(dst, src, n, tile);
+		if(tick(MODE_END) >= config.steps.time_guide_value) return steps;
+		steps *= 2;
+	}
+}
+
+/**
+ * repeat the matrix function and print one table line
+ */
+int matrix_test(matrix_option_info_t *option, unsigned_huge n, unsigned_huge tile) {
+	double *src, *dst;
+	if(!matrix_buffers(n, &src, &dst)) {
+		_printf("WARNING: couldn't init two %Lux%Lu matrices for matrix benchmark\n", n, n);
+		return -1;
+	}
+	unsigned_huge i;
+	for(i=0; i<n*n; i++) src[i] = i;
+	memset(dst, 0, n*n*sizeof(double));
+	matrix_fn_t matrix_fn = option->matrix_fn;
+
+	unsigned_huge steps = matrix_calculate_steps(matrix_fn, dst, src, n, tile);
+	unsigned_huge repetitions = config.repetitions.number;
+	if(config.repetitions.time_guide_value != 0) repetitions = 10000;
+
+	int r;
+	for(r=0; r<config.warmup; r++) {
+		for(i=0; i<steps; i++) matrix_fn(dst, src, n, tile);
+	}
+
+	double *time_single = (double*)malloc((repetitions+1)*sizeof(double));
+	statistic_t stat_time = STATISTIC_T_INIT;
+	for(r=0; r<repetitions; r++) {
+		sched_yield();
+		tick(MODE_START);
+		for(i=0; i<steps; i++) matrix_fn(dst, src, n, tile);
+		time_single[r] = tick(MODE_END);
+		calculate_statistics_iterative(&stat_time, time_single[r]);
+
+		if(config.repetitions.time_guide_value != 0 && r > config.repetitions.min) {
+			if(stat_time.mean * (r + 1) > config.repetitions.time_guide_value) {
+				repetitions = r+1;
+				break;
+			}
+		}
+	}
+	stat_time = middle_stat(time_single, repetitions);
+	free(time_single);
+
+	// every element is read once and written once
+	double bytes = 2.0 * n * n * sizeof(double);
+	double call_time = stat_time.mean / steps;
+	print_table_cell("%{repetitions}5d, ", repetitions);
+	print_table_cell("%{steps}9Lu, ", steps);
+	print_table_cell("%{dimension}7Lu, ", n);
+	print_table_cell("%{tile}5Lu, ", tile);
+	print_table_cell("%{matrix bytes}12Lu, ", n*n*sizeof(double));
+	print_table_cell("%{call time ns}" PRECISSION "f, ", call_time * 1e9);
+	print_table_cell("%{call time deviation ns}" PRECISSION "f, ", stat_time.deviation / steps * 1e9);
+	print_table_cell("%{bandwidth}" BIG_PRECISSION "f, ", bytes / MB / call_time);
+	print_table_cell("%{ns per element}" PRECISSION "f, ", call_time * 1e9 / (n*n));
+	print_table_line();
+	return 1;
+}
+
+void start_matrix_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("matrix benchmark\n");
+	_printf("dimension x dimension matrices of doubles (range), tile edge in elements (blocksize)\n");
+	_printf("bandwidth counts every element read once and written once, in Mebibyte / second\n");
+	_printf("buffer allocation: %s\n", memory_alloc_name(config.memory.alloc));
+	_printf("###############\n");
+
+	if(option == NULL || strcmp(option, "all") == 0) option = "transpose,transpose-blocked,"
+			"transpose-oblivious,copy,copy-tiled";
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	matrix_option_info_t *matrix_option = NULL;
+
+	// search for corresponding matrix function
+	int set_matrix_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+
+		matrix_option_info_t *ptr = matrix_option_infos;
+		while(ptr->name != NULL && strcmp(options[num_option], ptr->name) != 0) ptr++;
+		if(ptr->name == NULL) {
+			_printf("WARNING: unknown option for matrix benchmark: %s\n", options[num_option]);
+			return NESTED_FOR_CONT;
+		}
+		matrix_option = ptr;
+		print_table_set_additional_info("matrix function", ptr->name);
+		print_header();
+		return 0;
+	}
+
+	// exit tile loop, if the function doesn't use tiles
+	int check_for_tile_fn(unsigned level, iteration_var_t *vec) {
+		if(!(matrix_option->uses & MATRIX_USES_TILE)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge n, tile;
+		if(get_iteration_value("range", level, vec, &n)) return NESTED_FOR_BREAK;
+		if(get_iteration_value("tile", level, vec, &tile)) tile = 0;
+		if(!(matrix_option->uses & MATRIX_USES_TILE)) tile = 0;
+		else if(tile == 0) return NESTED_FOR_CONT;
+		if(n == 0) return NESTED_FOR_CONT;
+
+		if(matrix_test(matrix_option, n, tile) < 0) {
+			return NESTED_FOR_BREAK;
+		}
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_matrix_fn;
+
+	for_loop_t range_loop = FOR_LOOP_T_INIT;
+	range_loop.var.name = "range";
+	range_loop.var.range = config.range;
+	range_loop.step_fn = &step_range;
+
+	for_loop_t tile_loop = FOR_LOOP_T_INIT;
+	tile_loop.var.name = "tile";
+	tile_loop.var.range = config.memory.blocksize;
+	tile_loop.step_fn = &step_range;
+	tile_loop.inner_end_fn = &check_for_tile_fn;
+
+	option_loop.next = &range_loop;
+	range_loop.next = &tile_loop;
+
+	nested_for_loop(&option_loop, fn);
+
+	memory_buffer_free(&matrix_buffer);
+}
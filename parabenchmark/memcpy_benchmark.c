@@ -0,0 +1,381 @@
+/*
+ * memcpy_benchmark.c
+ *
+ * Compare copy and fill implementations (glibc, rep movsb/stosb and SIMD
+ * loops) over sizes, alignment offsets and overlap.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "memcpy_benchmark.h"
+#include "memory_functions.h"
+#include "memory_simd.h"
+#include "parse.h"
+#include "nested_for.h"
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+
+extern config_t config;
+
+typedef void (*copy_fn_t)(char *dst, char *src, size_t n);
+
+/**
+ * sweep dimensions, which are used by a copy function
+ */
+#define COPY_USES_SRC		0x01	// reads a source (not a fill)
+#define COPY_USES_OVERLAP	0x02	// handles overlapping buffers
+
+typedef struct {
+	char *name;
+	copy_fn_t copy_fn;
+	unsigned uses;
+	simd_level_t level;	// required instruction set
+} copy_option_info_t;
+
+/**
+ * glibc functions, called through a pointer so that they are not inlined
+ */
+void copy_libc_memcpy(char *dst, char *src, size_t n) {
+	memcpy(dst, src, n);
+}
+
+void copy_libc_memmove(char *dst, char *src, size_t n) {
+	memmove(dst, src, n);
+}
+
+void copy_libc_memset(char *dst, char *src, size_t n) {
+	(void)src;
+	memset(dst, 1, n);
+}
+
+/**
+ * string instructions, fast on cpus with ERMSB
+ */
+void copy_movsb(char *dst, char *src, size_t n) {
+	asm volatile (
+		"rep movsb;"
+		: "+D" (dst), "+S" (src), "+c" (n)
+		:
+		: "memory"
+	);
+}
+
+void copy_stosb(char *dst, char *src, size_t n) {
+	(void)src;
+	asm volatile (
+		"mov $1, %%al;"
+		"rep stosb;"
+		: "+D" (dst), "+c" (n)
+		:
+		: "rax", "memory"
+	);
+}
+
+/**
+ * Copy 'width' bytes per iteration with unaligned loads and stores. The
+ * last vector is copied from the end, overlapping with the previous one,
+ * so that no scalar tail is necessary. Copies shorter than one vector use
+ * rep movsb
+ */
+#define SIMD_COPY(level, load, store, reg, width, tail) \
+void copy_ ## level(char *dst, char *src, size_t n) { \
+	if(n < width) { \
+		copy_movsb(dst, src, n); \
+		return; \
+	} \
+	char *last_dst = dst + n - width; \
+	char *last_src = src + n - width; \
+	asm volatile ( \
+		"1:" \
+		load " (%[s]), %%" reg "0;" \
+		store " %%" reg "0, (%[d]);" \
+		"add $" #width ", %[s];" \
+		"add $" #width ", %[d];" \
+		"cmp %[ld], %[d];" \
+		"jb 1b;" \
+		load " (%[ls]), %%" reg "0;" \
+		store " %%" reg "0, (%[ld]);" \
+		tail \
+		: [d] "+r" (dst), [s] "+r" (src) \
+		: [ld] "r" (last_dst), [ls] "r" (last_src) \
+		: AVX_CLOBBERS, "cc", "memory" \
+	); \
+}
+
+SIMD_COPY(sse2, "movdqu", "movdqu", "xmm", 16, )
+SIMD_COPY(avx2, "vmovdqu", "vmovdqu", "ymm", 32, "vzeroupper;")
+SIMD_COPY(avx512, "vmovdqu64", "vmovdqu64", "zmm", 64, "vzeroupper;")
+
+/**
+ * Non-temporal copy: the first vector is copied unaligned, then the
+ * stores continue at the next 16 byte boundary of the destination with
+ * movntdq. The last vector is a regular store from the end
+ */
+void copy_nt(char *dst, char *src, size_t n) {
+	if(n < 32) {
+		copy_movsb(dst, src, n);
+		return;
+	}
+	char *last_dst = dst + n - 16;
+	char *last_src = src + n - 16;
+	size_t skip = 16 - ((uintptr_t)dst & 15);
+	asm volatile (
+		"movdqu (%[s]), %%xmm0;"
+		"movdqu %%xmm0, (%[d]);"
+		"add %[skip], %[s];"
+		"add %[skip], %[d];"
+		"cmp %[ld], %[d];"
+		"ja 2f;"
+		"1:"
+		"movdqu (%[s]), %%xmm0;"
+		"movntdq %%xmm0, (%[d]);"
+		"add $16, %[s];"
+		"add $16, %[d];"
+		"cmp %[ld], %[d];"
+		"jbe 1b;"
+		"2:"
+		"movdqu (%[ls]), %%xmm0;"
+		"movdqu %%xmm0, (%[ld]);"
+		"sfence;"
+		: [d] "+r" (dst), [s] "+r" (src)
+		: [ld] "r" (last_dst), [ls] "r" (last_src), [skip] "r" (skip)
+		: AVX_CLOBBERS, "cc", "memory"
+	);
+}
+
+copy_option_info_t copy_option_infos[] = {
+		{"memcpy", &copy_libc_memcpy, COPY_USES_SRC, SIMD_SCALAR},
+		{"memmove", &copy_libc_memmove, COPY_USES_SRC | COPY_USES_OVERLAP, SIMD_SCALAR},
+		{"memset", &copy_libc_memset, 0, SIMD_SCALAR},
+		{"movsb", &copy_movsb, COPY_USES_SRC, SIMD_SCALAR},
+		{"stosb", &copy_stosb, 0, SIMD_SCALAR},
+		{"sse2", &copy_sse2, COPY_USES_SRC, SIMD_SSE2},
+		{"avx2", &copy_avx2, COPY_USES_SRC, SIMD_AVX2},
+		{"avx512", &copy_avx512, COPY_USES_SRC, SIMD_AVX512},
+		{"nt", &copy_nt, COPY_USES_SRC, SIMD_SSE2},
+		{NULL, NULL, 0, SIMD_SCALAR}
+};
+
+memory_buffer_t copy_buffer = MEMORY_BUFFER_T_INIT;
+
+/**
+ * Place source and destination in one buffer. Without overlap both start
+ * at a page boundary plus their offset, with overlap the destination
+ * starts 'overlap' bytes before the end of the source
+ */
+bool copy_buffers(unsigned_huge size, unsigned_huge src_offset, unsigned_huge dst_offset,
+		unsigned_huge overlap, char **src, char **dst) {
+	unsigned_huge page = 4096;
+	unsigned_huge region = (size + src_offset + dst_offset + page) / page * page;
+	char *buffer = (char *)memory_buffer_get(&copy_buffer, 2*region + page, 1, -1);
+	if(buffer == NULL) return false;
+	char *base = (char *)(((uintptr_t)buffer + page - 1) & ~((uintptr_t)page - 1));
+	*src = base + src_offset;
+	*dst = base + region + dst_offset;
+	if(overlap > 0) {
+		*dst = *src + size - overlap;
+	}
+	return true;
+}
+
+/**
+ * calls per time measurement
+ */
+unsigned_huge copy_calculate_steps(copy_fn_t copy_fn, char *dst, char *src, size_t size) {
+	if(config.steps.time_guide_value == 0) return config.steps.number;
+	unsigned_huge steps = config.steps.min > 0 ? config.steps.min : 1;
+	while(true) {
+		unsigned_huge i;
+		tick(MODE_START);
+		for(i=0; i<steps; i++) copy_fn(dst, src, size);
+		if(tick(MODE_END) >= config.steps.time_guide_value) return steps;
+		steps *= 2;
+	}
+}
+
+/**
+ * repeat the copy function and print one table line
+ */
+int copy_test(copy_option_info_t *option, unsigned_huge size, unsigned_huge src_offset,
+		unsigned_huge dst_offset, unsigned_huge overlap) {
+	char *src, *dst;
+	if(!copy_buffers(size, src_offset, dst_offset, overlap, &src, &dst)) {
+		_printf("WARNING: couldn't init %Lu bytes for memcpy benchmark\n", size);
+		return -1;
+	}
+	memset(src, 2, size);
+	copy_fn_t copy_fn = option->copy_fn;
+
+	unsigned_huge steps = copy_calculate_steps(copy_fn, dst, src, size);
+	unsigned_huge repetitions = config.repetitions.number;
+	if(config.repetitions.time_guide_value != 0) repetitions = 10000;
+
+	int r;
+	unsigned_huge i;
+	for(r=0; r<config.warmup; r++) {
+		for(i=0; i<steps; i++) copy_fn(dst, src, size);
+	}
+
+	double *time_single = (double*)malloc((repetitions+1)*sizeof(double));
+	statistic_t stat_time = STATISTIC_T_INIT;
+	for(r=0; r<repetitions; r++) {
+		sched_yield();
+		tick(MODE_START);
+		for(i=0; i<steps; i++) copy_fn(dst, src, size);
+		time_single[r] = tick(MODE_END);
+		calculate_statistics_iterative(&stat_time, time_single[r]);
+
+		if(config.repetitions.time_guide_value != 0 && r > config.repetitions.min) {
+			if(stat_time.mean * (r + 1) > config.repetitions.time_guide_value) {
+				repetitions = r+1;
+				break;
+			}
+		}
+	}
+	stat_time = middle_stat(time_single, repetitions);
+	free(time_single);
+
+	double call_time = stat_time.mean / steps;
+	double bandwidth = steps * ((double) size) / MB / stat_time.mean;
+	print_table_cell("%{repetitions}5d, ", repetitions);
+	print_table_cell("%{steps}9Lu, ", steps);
+	print_table_cell("%{size}10Lu, ", size);
+	if(option->uses & COPY_USES_SRC) {
+		print_table_cell("%{src offset}4Lu, ", src_offset);
+	}
+	print_table_cell("%{dst offset}4Lu, ", dst_offset);
+	if(option->uses & COPY_USES_OVERLAP) {
+		print_table_cell("%{overlap}10Lu, ", overlap);
+	}
+	print_table_cell("%{call time ns}" PRECISSION "f, ", call_time * 1e9);
+	print_table_cell("%{call time deviation ns}" PRECISSION "f, ", stat_time.deviation / steps * 1e9);
+	print_table_cell("%{bandwidth}" BIG_PRECISSION "f, ", bandwidth);
+	print_table_cell("%{sample size}4Lu, ", stat_time.sample_size);
+	print_table_line();
+	return 1;
+}
+
+void start_memcpy_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("memcpy benchmark\n");
+	_printf("bandwidth is Mebibyte / second = 1024*1024 byte / second\n");
+	_printf("buffer allocation: %s\n", memory_alloc_name(config.memory.alloc));
+	_printf("###############\n");
+
+	if(option == NULL || strcmp(option, "all") == 0) option = "memcpy,memmove,memset,"
+			"movsb,stosb,sse2,avx2,avx512,nt";
+	if(strcmp(option, "copy") == 0) option = "memcpy,movsb,sse2,avx2,avx512,nt";
+	if(strcmp(option, "set") == 0) option = "memset,stosb";
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	copy_option_info_t *copy_option = NULL;
+
+	// search for corresponding copy function
+	int set_copy_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+
+		copy_option_info_t *ptr = copy_option_infos;
+		while(ptr->name != NULL && strcmp(options[num_option], ptr->name) != 0) ptr++;
+		if(ptr->name == NULL) {
+			_printf("WARNING: unknown option for memcpy benchmark: %s\n", options[num_option]);
+			return NESTED_FOR_CONT;
+		}
+		simd_level_t level_required = ptr->level;
+		if(!simd_check_level(&level_required)) return NESTED_FOR_CONT;
+		copy_option = ptr;
+		print_table_set_additional_info("copy function", ptr->name);
+		print_header();
+		return 0;
+	}
+
+	// exit source offset loop, if the function only writes
+	int check_for_src_fn(unsigned level, iteration_var_t *vec) {
+		if(!(copy_option->uses & COPY_USES_SRC)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit overlap loop, if the function doesn't support overlapping buffers
+	int check_for_overlap_fn(unsigned level, iteration_var_t *vec) {
+		if(!(copy_option->uses & COPY_USES_OVERLAP)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge size;
+		if(get_iteration_value("range", level, vec, &size)) return NESTED_FOR_BREAK;
+		unsigned_huge src_offset, dst_offset, overlap;
+		if(get_iteration_value("src offset", level, vec, &src_offset)) src_offset = 0;
+		if(get_iteration_value("dst offset", level, vec, &dst_offset)) dst_offset = 0;
+		if(get_iteration_value("overlap", level, vec, &overlap)) overlap = 0;
+		if(!(copy_option->uses & COPY_USES_SRC)) src_offset = 0;
+		if(!(copy_option->uses & COPY_USES_OVERLAP)) overlap = 0;
+		// the destination has to start behind the source
+		if(overlap >= size && overlap > 0) return NESTED_FOR_CONT;
+
+		if(copy_test(copy_option, size, src_offset, dst_offset, overlap) < 0) {
+			return NESTED_FOR_BREAK;
+		}
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_copy_fn;
+
+	for_loop_t range_loop = FOR_LOOP_T_INIT;
+	range_loop.var.name = "range";
+	range_loop.var.range = config.range;
+	range_loop.step_fn = &step_range;
+
+	for_loop_t src_offset_loop = FOR_LOOP_T_INIT;
+	src_offset_loop.var.name = "src offset";
+	src_offset_loop.var.range = config.copy.src_offset;
+	src_offset_loop.step_fn = &step_range;
+	src_offset_loop.inner_end_fn = &check_for_src_fn;
+
+	for_loop_t dst_offset_loop = FOR_LOOP_T_INIT;
+	dst_offset_loop.var.name = "dst offset";
+	dst_offset_loop.var.range = config.copy.dst_offset;
+	dst_offset_loop.step_fn = &step_range;
+
+	for_loop_t overlap_loop = FOR_LOOP_T_INIT;
+	overlap_loop.var.name = "overlap";
+	overlap_loop.var.range = config.copy.overlap;
+	overlap_loop.step_fn = &step_range;
+	overlap_loop.inner_end_fn = &check_for_overlap_fn;
+
+	option_loop.next = &range_loop;
+	range_loop.next = &src_offset_loop;
+	src_offset_loop.next = &dst_offset_loop;
+	dst_offset_loop.next = &overlap_loop;
+
+	nested_for_loop(&option_loop, fn);
+
+	memory_buffer_free(&copy_buffer);
+}
@@ -0,0 +1,30 @@
+/*
+ * memcpy_benchmark.h
+ *
+ * Compare copy and fill implementations (glibc, rep movsb/stosb and SIMD
+ * loops) over sizes, alignment offsets and overlap.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMCPY_BENCHMARK_H
+#define __MEMCPY_BENCHMARK_H
+
+#include "definitions.h"
+
+void start_memcpy_benchmark(char *option);
+
+#endif
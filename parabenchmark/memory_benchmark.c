@@ -29,6 +29,12 @@
 #include "getopt.h"
 #include "parse.h"
 #include "nested_for.h"
+#include "memory_simd.h"
+#include "memory_latency.h"
+#include "memory_functions.h"
+#include "memory_hierarchy.h"
+#include "memory_prefetch.h"
+#include "memory_width.h"
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/resource.h>
@@ -36,29 +42,28 @@
 
 #define __USE_GNU
 #include <sched.h>
+#include <pthread.h>
 #include <sys/sysinfo.h>
+#include "pthread_functions.h"
 
 
 unsigned long long max_malloc_arg();
 void mem_clear_steps_cache();
 unsigned mem_calculate_repetitions(memory_function_arg_t arg, access_fn_t access_fn);
 unsigned mem_calculate_steps(memory_function_arg_t arg, access_fn_t access_fn);
-int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn);
+int memory_bandwidth_test(memory_function_arg_t arg, memory_option_info_t *option);
 
 #define MEMORY_MIN_BUFFER_SIZE 128
-/**
- * Variables for random number generator.
- * See http://www.metachaos.net/resume/SampleCode3.html
- */
-#define RANDOM_A 6364136223846793005
-#define RANDOM_C 1442695040888963407
+
+// additional data sizes measured between the sizes around a knee
+#define MEMORY_REFINE_POINTS 3
 
 /**
  * iterate over steps, strides and bytes of a blocks, while measuring the time
  */
 #define LOOP_SKELETON(accesstype, reginit, \
 		strideinit, stridecount, strideaccess, blocksize, \
-		intstruction, result) \
+		intstruction, epilogue, result) \
 	{ \
 			register volatile accesstype *buffer_ptr; \
 			register volatile accesstype *p; \
@@ -70,7 +75,7 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn);
 			register unsigned long long step; \
 			step = steps; \
 			sched_yield(); \
-			tick(MODE_START); \
+			tick_thread(MODE_START); \
 			while(step-->0) \
 			{ \
 				strideinit; \
@@ -89,7 +94,8 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn);
 					} \
 				} \
 			} \
-			result = tick(MODE_END); \
+			epilogue; \
+			result = tick_thread(MODE_END); \
 			use(tmp); \
 			use_pointer((void *)p); \
 		}
@@ -98,13 +104,13 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn);
  */
 #define BENCHMARK_SKELETON(accesstype, reginit, \
 	strideinit, stridecount, strideaccess, blocksize, \
-	overheadinstr, accessinstr, result) \
+	overheadinstr, accessinstr, epilogue, result) \
 	static unsigned benchmark_skeleton_pass = 0; \
 	void inline1() { \
-		LOOP_SKELETON(accesstype, reginit, strideinit, stridecount, strideaccess, blocksize, accessinstr, result.time); \
+		LOOP_SKELETON(accesstype, reginit, strideinit, stridecount, strideaccess, blocksize, accessinstr, epilogue, result.time); \
 	} \
 	void inline2() { \
-		LOOP_SKELETON(accesstype, reginit, strideinit, stridecount, strideaccess, blocksize, overheadinstr, result.overhead);\
+		LOOP_SKELETON(accesstype, reginit, strideinit, stridecount, strideaccess, blocksize, overheadinstr, epilogue, result.overhead);\
 	} \
 	if(benchmark_skeleton_pass++ %2 == 0) {inline1(); inline2();} else {inline2(); inline1();}
 
@@ -128,6 +134,20 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn);
 #define READWRITE_ACCESS \
 	"add %" REGACCESS "[tmp], (%[p]);"
 
+/* non-temporal stores bypass the caches (no read for ownership) */
+#define WRITE_NT_ACCESS \
+	"movnti %" REGACCESS "[tmp], (%[p]);"
+#define READWRITE_NT_OVERHEAD \
+	"add %" REGACCESS "[p], %" REGACCESS "[tmp];" \
+	"mov %" REGACCESS "[tmp], %" REGACCESS "[p];"
+#define READWRITE_NT_ACCESS \
+	"add (%[p]), %" REGACCESS "[tmp];" \
+	"movnti %" REGACCESS "[tmp], (%[p]);"
+
+/* make the non-temporal stores globally visible before the time is taken */
+#define NT_EPILOGUE \
+	asm volatile ("sfence;" ::: "memory")
+
 /**
  * dummy functions to disable optimization
  */
@@ -213,6 +233,8 @@ memory_result_t test_continued_readwrite(memory_function_arg_t arg) {
 		READWRITE_OVERHEAD,
 		/* memory access instruction */
 		READWRITE_ACCESS,
+		/* epilogue */
+		,
 		result
 		)
 	result.transmitted = steps * ((double) last) * blocksize * sizeof(ACCESS_TYPE);
@@ -255,6 +277,97 @@ memory_result_t test_continued_write(memory_function_arg_t arg) {
 		WRITE_OVERHEAD,
 		/* memory access instruction */
 		WRITE_ACCESS,
+		/* epilogue */
+		,
+		result
+		)
+
+	result.transmitted = arg.steps * ((double) last) * blocksize * sizeof(ACCESS_TYPE);
+	result.datasize_enough = true;
+	result.blocksize = blocksize * sizeof(ACCESS_TYPE);
+	result.stride = stride * sizeof(ACCESS_TYPE);
+	return result;
+}
+
+/**
+ * Test for continued read/write with non-temporal stores
+ */
+memory_result_t test_continued_readwrite_nt(memory_function_arg_t arg) {
+	double time = 0;
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	unsigned_huge datasize = arg.data_size/sizeof(ACCESS_TYPE);
+	unsigned_huge blocksize = arg.blocksize/sizeof(ACCESS_TYPE);
+	unsigned_huge stride = arg.stride/sizeof(ACCESS_TYPE);
+	unsigned_huge last = datasize/(blocksize+stride);
+	if(last == 0 || blocksize == 0) {
+		result.datasize_enough = false;
+		return result;
+	}
+
+	unsigned_huge steps = arg.steps;
+	BENCHMARK_SKELETON(
+		/* access type */
+		ACCESS_TYPE,
+		/* register init */
+		buffer_ptr = arg.buffer;,
+		/* stride init */
+		p = buffer_ptr;,
+		/* stride count */
+		last,
+		/* stride access */
+		p += stride;,	// p is incremented by macro
+		/* block size */
+		blocksize,
+		/* overhead instruction */
+		READWRITE_NT_OVERHEAD,
+		/* memory access instruction */
+		READWRITE_NT_ACCESS,
+		/* epilogue */
+		NT_EPILOGUE,
+		result
+		)
+	result.transmitted = steps * ((double) last) * blocksize * sizeof(ACCESS_TYPE);
+	result.datasize_enough = true;
+	result.blocksize = blocksize * sizeof(ACCESS_TYPE);
+	result.stride = stride * sizeof(ACCESS_TYPE);
+	return result;
+}
+
+/**
+ * Test for continued write with non-temporal stores
+ */
+memory_result_t test_continued_write_nt(memory_function_arg_t arg) {
+	double time = 0;
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	unsigned_huge datasize = arg.data_size/sizeof(ACCESS_TYPE);
+	unsigned_huge blocksize = arg.blocksize/sizeof(ACCESS_TYPE);
+	unsigned_huge stride = arg.stride/sizeof(ACCESS_TYPE);
+	unsigned_huge last = datasize/(blocksize+stride);
+	if(last == 0 || blocksize == 0) {
+		result.datasize_enough = false;
+		return result;
+	}
+
+	unsigned_huge steps = arg.steps;
+	BENCHMARK_SKELETON(
+		/* access type */
+		ACCESS_TYPE,
+		/* register init */
+		buffer_ptr = arg.buffer;,
+		/* stride init */
+		p = buffer_ptr;,
+		/* stride count */
+		last,
+		/* stride access */
+		p += stride;,	// p is incremented by macro
+		/* block size */
+		blocksize,
+		/* overhead instruction */
+		WRITE_OVERHEAD,
+		/* memory access instruction */
+		WRITE_NT_ACCESS,
+		/* epilogue */
+		NT_EPILOGUE,
 		result
 		)
 
@@ -298,6 +411,8 @@ memory_result_t test_continued_read(memory_function_arg_t arg) {
 		READ_OVERHEAD,
 		/* memory access instruction */
 		READ_ACCESS,
+		/* epilogue */
+		,
 		result
 		)
 
@@ -347,6 +462,8 @@ memory_result_t test_random_readwrite(memory_function_arg_t arg) {
 		READWRITE_OVERHEAD,
 		/* memory access instruction */
 		READWRITE_ACCESS,
+		/* epilogue */
+		,
 		result
 		)
 
@@ -397,6 +514,8 @@ memory_result_t test_random_write(memory_function_arg_t arg) {
 		WRITE_OVERHEAD,
 		/* memory access instruction */
 		WRITE_ACCESS,
+		/* epilogue */
+		,
 		result
 		)
 
@@ -447,6 +566,8 @@ memory_result_t test_random_read(memory_function_arg_t arg) {
 		READ_OVERHEAD,
 		/* memory access instruction */
 		READ_ACCESS,
+		/* epilogue */
+		,
 		result
 		)
 
@@ -459,50 +580,133 @@ memory_result_t test_random_read(memory_function_arg_t arg) {
 }
 
 /**
- * Allocate arrays for flooding CPU caches
+ * bring the caches into the configured state, see config.memory.cache_state
  */
-volatile void *cache_clear_memcpya = NULL;
-volatile void *cache_clear_memcpyb = NULL;
 statistic_t cache_clear_stat = STATISTIC_T_INIT;
-void cache_clear_init() {
-	unsigned_huge size = config.memory.cache_clean_size;
-	init_array(size, &cache_clear_memcpya);
-	init_array(size, &cache_clear_memcpyb);
-	if(cache_clear_memcpya == NULL || cache_clear_memcpyb == NULL) {
-		_printf("WARNING: cache clear couldn't allocate buffer\n");
+double memory_cache_clear(volatile void *buffer, unsigned_huge size) {
+	double time = cache_clear(buffer, size);
+	calculate_statistics_iterative(&cache_clear_stat, time);
+	return time;
+}
+
+/**
+ * Execute an access function on a worker thread
+ */
+typedef struct {
+	memory_function_arg_t arg;
+	access_fn_t access_fn;
+	memory_result_t result;
+	double clear_time;
+	volatile unsigned *cleared;		// threads which have cleared their caches
+} memory_thread_data_t;
+
+memory_thread_mode_t memory_thread_mode = MEMORY_THREADS_SINGLE;
+memory_buffer_t memory_buffer = MEMORY_BUFFER_T_INIT;
+memory_curve_t memory_curve = MEMORY_CURVE_T_INIT;
+
+// processors of the actual cpu node (numa matrix mode)
+cpu_set_t memory_cpu_set;
+bool memory_cpu_set_valid = false;
+
+/**
+ * restrict calling thread to the processors of a numa node
+ */
+void memory_set_cpu_node(int node_index) {
+	numa_node_t *node = get_numa_node(node_index);
+	if(node == NULL) return;
+	CPU_ZERO(&memory_cpu_set);
+	int i;
+	for(i=0; i<node->cpu_size; i++) {
+		CPU_SET(node->cpus[i], &memory_cpu_set);
+	}
+	memory_cpu_set_valid = true;
+	if(sched_setaffinity(0, sizeof(memory_cpu_set), &memory_cpu_set) != 0) {
+		_printf("WARNING: failed to set cpu affinity to numa node %d\n", node->node_id);
 	}
 }
 
+void *memory_thread_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	memory_thread_data_t *data = (memory_thread_data_t*) arg->data;
+	// pool threads are shared with other tests, so restore their mask
+	cpu_set_t old_cpu_set;
+	bool restore = memory_cpu_set_valid
+			&& pthread_getaffinity_np(pthread_self(), sizeof(old_cpu_set), &old_cpu_set) == 0;
+	if(memory_cpu_set_valid) {
+		pthread_setaffinity_np(pthread_self(), sizeof(memory_cpu_set), &memory_cpu_set);
+	}
+	// every thread clears its own caches, then waits for the others, so
+	// that no thread measures while another one is still clearing
+	data->clear_time = cache_clear(data->arg.buffer, data->arg.data_size);
+	__sync_fetch_and_add(data->cleared, 1);
+	while(*data->cleared < arg->thread_count) {
+		sched_yield();
+	}
+	data->result = data->access_fn(data->arg);
+	if(restore) {
+		pthread_setaffinity_np(pthread_self(), sizeof(old_cpu_set), &old_cpu_set);
+	}
+	return (void *)NULL;
+}
+
 /**
- * Access random elements of two buffers to invalidate cache lines
+ * Bring the caches into the configured state and execute access function
+ * in the main thread or, if a thread mode is selected, on arg.threads
+ * worker threads. For the latter every thread clears the caches itself, the
+ * transmitted bytes are summed up and the time of the slowest thread is
+ * taken, so the resulting bandwidth is the aggregate bandwidth of all
+ * threads. The time of the cache clear is stored in 'clear_time', if it
+ * isn't NULL
  */
-void cache_clear() {
-	// for cleaning cache
-	unsigned_huge size = config.memory.cache_clean_size;
-
-	if(cache_clear_memcpya != NULL && cache_clear_memcpyb != NULL) {
-		double time;
-		tick(MODE_START);
-		unsigned_huge i, tmp;
-		long long x = 0;
-		volatile char *cache_a = (volatile char*) cache_clear_memcpya;
-		volatile char *cache_b = (volatile char*) cache_clear_memcpyb;
-		for(i=0; i<size; i+=128) {
-			x = RANDOM_A*x + RANDOM_C;
-			tmp = ((unsigned_huge)x)%size;
-			cache_a[tmp] = cache_b[tmp];
-			x = RANDOM_A*x + RANDOM_C;
-			tmp = ((int)x)%size;
-			cache_b[tmp] = cache_a[tmp];
+memory_result_t memory_access(memory_function_arg_t arg, access_fn_t access_fn, double *clear_time) {
+	if(memory_thread_mode == MEMORY_THREADS_SINGLE) {
+		double time = memory_cache_clear(arg.buffer, arg.data_size);
+		if(clear_time != NULL) *clear_time = time;
+		return access_fn(arg);
+	}
+
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	unsigned num_threads = arg.threads;
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL || num_threads == 0) {
+		result.datasize_enough = false;
+		return result;
+	}
+
+	memory_thread_data_t data[num_threads];
+	volatile unsigned cleared = 0;
+	int i;
+	for(i=0; i<num_threads; i++) {
+		data[i].arg = arg;
+		data[i].access_fn = access_fn;
+		data[i].cleared = &cleared;
+		if(memory_thread_mode == MEMORY_THREADS_PRIVATE) {
+			data[i].arg.buffer = ((volatile char *)arg.buffer) + i*arg.data_size;
 		}
-		time = tick(MODE_END);
-		calculate_statistics_iterative(&cache_clear_stat, time);
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &memory_thread_loop;
+		args[i].data = &data[i];
 	}
-}
 
-void cache_clear_finish() {
-	free((void*)cache_clear_memcpya);
-	free((void*)cache_clear_memcpyb);
+	threads_prepare(args, num_threads);
+	threads_start(args, num_threads);
+	threads_join(args, num_threads);
+
+	result = data[0].result;
+	double max_clear_time = data[0].clear_time;
+	for(i=1; i<num_threads; i++) {
+		memory_result_t *act = &data[i].result;
+		result.datasize_enough = result.datasize_enough && act->datasize_enough;
+		result.transmitted += act->transmitted;
+		result.accesses += act->accesses;
+		if(act->time > result.time) result.time = act->time;
+		if(act->overhead > result.overhead) result.overhead = act->overhead;
+		if(data[i].clear_time > max_clear_time) max_clear_time = data[i].clear_time;
+	}
+	calculate_statistics_iterative(&cache_clear_stat, max_clear_time);
+	if(clear_time != NULL) *clear_time = max_clear_time;
+	return result;
 }
 
 /**
@@ -510,21 +714,87 @@ void cache_clear_finish() {
  * first is default
  */
 memory_option_info_t memory_option_infos[] = {
-		{"contread", &test_continued_read, true},
-		{"cr", &test_continued_read, true},
-		{"contwrite", &test_continued_write, true},
-		{"cw", &test_continued_write, true},
-		{"contreadwrite", &test_continued_readwrite, true},
-		{"crw", &test_continued_readwrite, true},
-		{"randread", &test_random_read, false},
-		{"rr", &test_random_read, false},
-		{"randwrite", &test_random_write, false},
-		{"rw", &test_random_write, false},
-		{"randreadwrite", &test_random_readwrite, false},
-		{"rrw", &test_random_readwrite, false},
+		{"contread", &test_continued_read, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"cr", &test_continued_read, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"contwrite", &test_continued_write, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"cw", &test_continued_write, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"contreadwrite", &test_continued_readwrite, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"crw", &test_continued_readwrite, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"contwrite-nt", &test_continued_write_nt, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"contreadwrite-nt", &test_continued_readwrite_nt, MEMORY_USES_BLOCKSIZE | MEMORY_USES_STRIDE},
+		{"randread", &test_random_read, MEMORY_USES_BLOCKSIZE},
+		{"rr", &test_random_read, MEMORY_USES_BLOCKSIZE},
+		{"randwrite", &test_random_write, MEMORY_USES_BLOCKSIZE},
+		{"rw", &test_random_write, MEMORY_USES_BLOCKSIZE},
+		{"randreadwrite", &test_random_readwrite, MEMORY_USES_BLOCKSIZE},
+		{"rrw", &test_random_readwrite, MEMORY_USES_BLOCKSIZE},
+		// stream kernels, see memory_simd.c
+		{"copy", &test_stream_copy, 0, &stream_init},
+		{"scale", &test_stream_scale, 0, &stream_init},
+		{"add", &test_stream_add, 0, &stream_init},
+		{"triad", &test_stream_triad, 0, &stream_init},
+		{"copy-scalar", &test_stream_copy_scalar, 0, &stream_init},
+		{"copy-sse2", &test_stream_copy_sse2, 0, &stream_init},
+		{"copy-avx2", &test_stream_copy_avx2, 0, &stream_init},
+		{"copy-avx512", &test_stream_copy_avx512, 0, &stream_init},
+		{"scale-scalar", &test_stream_scale_scalar, 0, &stream_init},
+		{"scale-sse2", &test_stream_scale_sse2, 0, &stream_init},
+		{"scale-avx2", &test_stream_scale_avx2, 0, &stream_init},
+		{"scale-avx512", &test_stream_scale_avx512, 0, &stream_init},
+		{"add-scalar", &test_stream_add_scalar, 0, &stream_init},
+		{"add-sse2", &test_stream_add_sse2, 0, &stream_init},
+		{"add-avx2", &test_stream_add_avx2, 0, &stream_init},
+		{"add-avx512", &test_stream_add_avx512, 0, &stream_init},
+		{"triad-scalar", &test_stream_triad_scalar, 0, &stream_init},
+		{"triad-sse2", &test_stream_triad_sse2, 0, &stream_init},
+		{"triad-avx2", &test_stream_triad_avx2, 0, &stream_init},
+		{"triad-avx512", &test_stream_triad_avx512, 0, &stream_init},
+		// simd stores, see memory_simd.c
+		{"contwrite-sse2", &test_contwrite_sse2, 0},
+		{"contwrite-avx2", &test_contwrite_avx2, 0},
+		{"contwrite-avx512", &test_contwrite_avx512, 0},
+		{"contwrite-nt-sse2", &test_contwrite_nt_sse2, 0},
+		{"contwrite-nt-avx2", &test_contwrite_nt_avx2, 0},
+		{"contwrite-nt-avx512", &test_contwrite_nt_avx512, 0},
+		{"contreadwrite-sse2", &test_contreadwrite_sse2, 0},
+		{"contreadwrite-avx2", &test_contreadwrite_avx2, 0},
+		{"contreadwrite-avx512", &test_contreadwrite_avx512, 0},
+		{"contreadwrite-nt-sse2", &test_contreadwrite_nt_sse2, 0},
+		{"contreadwrite-nt-avx2", &test_contreadwrite_nt_avx2, 0},
+		{"contreadwrite-nt-avx512", &test_contreadwrite_nt_avx512, 0},
+		// pointer chasing, see memory_latency.c
+		{"chaseline", &test_chase_line, 0, &chase_line_init},
+		{"chasepage", &test_chase_page, 0, &chase_page_init},
+		{"chasetlb", &test_chase_tlb, 0, &chase_tlb_init},
+		{"mlp", &test_mlp, MEMORY_USES_CHAINS, &chase_line_init},
+		// software prefetch, see memory_prefetch.c
+		{"prefetch-seq-t0", &test_prefetch_seq_t0, MEMORY_USES_DISTANCE},
+		{"prefetch-seq-t2", &test_prefetch_seq_t2, MEMORY_USES_DISTANCE},
+		{"prefetch-seq-nta", &test_prefetch_seq_nta, MEMORY_USES_DISTANCE},
+		{"prefetch-stride-t0", &test_prefetch_stride_t0, MEMORY_USES_DISTANCE | MEMORY_USES_STRIDE},
+		{"prefetch-stride-t2", &test_prefetch_stride_t2, MEMORY_USES_DISTANCE | MEMORY_USES_STRIDE},
+		{"prefetch-stride-nta", &test_prefetch_stride_nta, MEMORY_USES_DISTANCE | MEMORY_USES_STRIDE},
+		{"prefetch-page-t0", &test_prefetch_page_t0, MEMORY_USES_DISTANCE},
+		{"prefetch-page-t2", &test_prefetch_page_t2, MEMORY_USES_DISTANCE},
+		{"prefetch-page-nta", &test_prefetch_page_nta, MEMORY_USES_DISTANCE},
+		// access width sweep, see memory_width.c
+		{"width-read", &test_width_read, MEMORY_USES_WIDTH},
+		{"width-write", &test_width_write, MEMORY_USES_WIDTH},
+		{"width-readwrite", &test_width_readwrite, MEMORY_USES_WIDTH},
 		{NULL, NULL}
 };
 
+/**
+ * access function with the given name, NULL if there is none
+ */
+memory_option_info_t *memory_find_option(char *name) {
+	memory_option_info_t *ptr = memory_option_infos;
+	for(; ptr->name != NULL; ptr++) {
+		if(strcmp(ptr->name, name) == 0) return ptr;
+	}
+	return NULL;
+}
+
 /**
  * start memory bandwidth benchmark according to command line options
  */
@@ -532,9 +802,21 @@ void start_memory_bandwidth_benchmark(char *option) {
 	_printf("\n### RESULTS ###\n");
 	_printf("memory bandwidth benchmark\n");
 	_printf("bandwidth is Mebibyte / second = 1024*1024 byte / second\n");
+	_printf("buffer allocation: %s\n", memory_alloc_name(config.memory.alloc));
+	_printf("numa placement: %s\n", memory_numa_name(config.memory.numa));
+	_printf("cache state: %s", memory_cache_state_name(config.memory.cache_state));
+	if(config.memory.cache_state == CACHE_STATE_EVICT || config.memory.cache_state == CACHE_STATE_FULL) {
+		char *eviction_size_str = sprint_num_bytes(cache_eviction_size());
+		_printf(" (eviction buffer %s)", eviction_size_str);
+		free(eviction_size_str);
+	}
+	_printf("\n");
 	_printf("##############\n");
 	cache_clear_init();
 	memory_affinity();
+
+	get_thread_array(config.threads->end);
+
 	//unsigned_huge min_iterations = config.iterations.start;
 	//unsigned_huge max_iterations = config.iterations.end;
 	char *additional_info_header = "access function";
@@ -555,19 +837,49 @@ void start_memory_bandwidth_benchmark(char *option) {
 	if(strcmp(option, "contrev") == 0) option = "contreadwrite,contwrite,contread";
 	if(strcmp(option, "rand") == 0) option = "randread,randwrite,randreadwrite";
 	if(strcmp(option, "randrev") == 0) option = "randreadwrite,randwrite,randread";
+	if(strcmp(option, "nt") == 0) option = "contwrite,contwrite-nt,"
+			"contreadwrite,contreadwrite-nt";
+	if(strcmp(option, "nt-simd") == 0) option = "contwrite-sse2,contwrite-nt-sse2,"
+			"contwrite-avx2,contwrite-nt-avx2,contwrite-avx512,contwrite-nt-avx512,"
+			"contreadwrite-sse2,contreadwrite-nt-sse2,contreadwrite-avx2,contreadwrite-nt-avx2,"
+			"contreadwrite-avx512,contreadwrite-nt-avx512";
+	if(strcmp(option, "prefetch") == 0) option = "prefetch-seq-t0,prefetch-seq-t2,"
+			"prefetch-seq-nta,prefetch-stride-t0,prefetch-stride-t2,prefetch-stride-nta,"
+			"prefetch-page-t0,prefetch-page-t2,prefetch-page-nta";
+	if(strcmp(option, "width") == 0) option = "width-read,width-write,width-readwrite";
+	if(strcmp(option, "numa") == 0) option = "triad,chaseline";
+	if(strcmp(option, "chase") == 0) option = "chaseline,chasepage";
+	if(strcmp(option, "stream") == 0) option = "copy,scale,add,triad";
+	if(strcmp(option, "stream-simd") == 0) option = "triad-scalar,triad-sse2,"
+			"triad-avx2,triad-avx512";
 
 	// read tests
 	unsigned option_count;
 	char **options = get_token_array(option, &option_count);
 
 	// set access function using 'nested_for'
+	memory_option_info_t *memory_option = NULL;
 	access_fn_t access_fn = &test_random_read;
-	bool fn_uses_stride = false;
+	unsigned fn_uses = 0;
 	int set_access_fn(unsigned level, iteration_var_t *vec) {
 		unsigned_huge num_option;
 		get_iteration_value("option", level, vec, &num_option);
 		if(num_option > option_count) return NESTED_FOR_BREAK;
 
+		// thread mode for the following access functions
+		if(strcmp(options[num_option], "single") == 0) {
+			memory_thread_mode = MEMORY_THREADS_SINGLE;
+			return NESTED_FOR_CONT;
+		}
+		if(strcmp(options[num_option], "private") == 0) {
+			memory_thread_mode = MEMORY_THREADS_PRIVATE;
+			return NESTED_FOR_CONT;
+		}
+		if(strcmp(options[num_option], "shared") == 0) {
+			memory_thread_mode = MEMORY_THREADS_SHARED;
+			return NESTED_FOR_CONT;
+		}
+
 		mem_clear_steps_cache();
 		free(additional_info);
 		additional_info = NULL;
@@ -577,10 +889,17 @@ void start_memory_bandwidth_benchmark(char *option) {
 		memory_option_info_t *memory_option_ptr = memory_option_infos;
 		while(memory_option_ptr->name != NULL) {
 			if(strcmp(options[num_option], memory_option_ptr->name) == 0) {
+				memory_option = memory_option_ptr;
 				access_fn = memory_option_ptr->access_fn;
-				fn_uses_stride = memory_option_ptr->uses_stride;
+				fn_uses = memory_option_ptr->uses;
 				strappend(&additional_info, memory_option_ptr->name);
 				strappend(&additional_info, ", ");
+				if(memory_thread_mode == MEMORY_THREADS_PRIVATE) {
+					strappend(&additional_info, "private, ");
+				}
+				else if(memory_thread_mode == MEMORY_THREADS_SHARED) {
+					strappend(&additional_info, "shared, ");
+				}
 				found = true;
 				break;
 			}
@@ -590,6 +909,12 @@ void start_memory_bandwidth_benchmark(char *option) {
 			_printf("WARNING: unknown option for memory benchmark: %s\n", options[num_option]);
 			return NESTED_FOR_CONT;
 		}
+		if(memory_thread_mode == MEMORY_THREADS_SINGLE) {
+			additional_info_header = "access function";
+		}
+		else {
+			additional_info_header = "access function, thread mode";
+		}
 		print_table_set_additional_info(additional_info_header, additional_info);
 		return 0;
 	}
@@ -600,11 +925,17 @@ void start_memory_bandwidth_benchmark(char *option) {
 		return 0;
 	}
 
+	// cpu node the main thread is restricted to (numa matrix mode)
+	unsigned_huge last_cpu_node = -1;
+
 	// inline function that starts the right test function
 	int fn(unsigned level, iteration_var_t *vec) {
 		static access_fn_t last_access_fn = NULL;
 		static unsigned_huge last_stride = 0;
 		static unsigned_huge last_blocksize = 0;
+		static unsigned_huge last_chains = 0;
+		static unsigned_huge last_distance = 0;
+		static unsigned_huge last_width = 0;
 
 		unsigned_huge j;
 		if(get_iteration_value("range", level, vec, &j)) return NESTED_FOR_BREAK;
@@ -612,19 +943,61 @@ void start_memory_bandwidth_benchmark(char *option) {
 		if(get_iteration_value("stride", level, vec, &stride)) stride = 0;
 		unsigned_huge blocksize;
 		if(get_iteration_value("blocksize", level, vec, &blocksize)) blocksize = 32;
+		unsigned_huge chains;
+		if(get_iteration_value("chains", level, vec, &chains)) chains = 1;
+		if(!(fn_uses & MEMORY_USES_CHAINS)) chains = 1;
+		if(!(fn_uses & MEMORY_USES_BLOCKSIZE)) blocksize = 0;
+		if(!(fn_uses & MEMORY_USES_STRIDE)) stride = 0;
+		unsigned_huge distance;
+		if(get_iteration_value("distance", level, vec, &distance)) distance = 0;
+		if(!(fn_uses & MEMORY_USES_DISTANCE)) distance = 0;
+		unsigned_huge width;
+		if(get_iteration_value("width", level, vec, &width)) width = 0;
+		if(!(fn_uses & MEMORY_USES_WIDTH)) width = 0;
+		unsigned_huge num_threads;
+		if(get_iteration_value("thread", level, vec, &num_threads)) num_threads = 1;
+		if(memory_thread_mode == MEMORY_THREADS_SINGLE) num_threads = 1;
 		memory_function_arg_t arg;
 		arg.data_size = j;
 		arg.stride = stride;
-		arg.uses_stride = fn_uses_stride;
+		arg.uses_stride = (fn_uses & MEMORY_USES_STRIDE) != 0;
 		arg.blocksize = blocksize;
+		arg.threads = num_threads;
+		arg.chains = chains;
+		arg.distance = distance;
+		arg.width = width;
+
+		// numa placement
+		arg.cpu_node = -1;
+		arg.mem_node = -1;
+		if(config.memory.numa == NUMA_MATRIX) {
+			unsigned_huge cpu_node, mem_node;
+			get_iteration_value("cpu node", level, vec, &cpu_node);
+			get_iteration_value("mem node", level, vec, &mem_node);
+			if(cpu_node != last_cpu_node) {
+				memory_set_cpu_node(cpu_node);
+				last_cpu_node = cpu_node;
+			}
+			arg.cpu_node = get_numa_node(cpu_node)->node_id;
+			arg.mem_node = get_numa_node(mem_node)->node_id;
+		}
+		else if(config.memory.numa == NUMA_BIND) {
+			arg.mem_node = config.memory.numa_node;
+		}
+		else if(config.memory.numa == NUMA_LOCAL) {
+			arg.mem_node = get_numa_node_of_cpu(sched_getcpu());
+		}
 
-		if(access_fn != last_access_fn || last_stride != stride || last_blocksize != blocksize) {
+		if(access_fn != last_access_fn || last_stride != stride || last_blocksize != blocksize
+				|| last_chains != chains || last_distance != distance
+				|| last_width != width) {
 			last_access_fn = access_fn; last_stride = stride; last_blocksize = blocksize;
+			last_chains = chains; last_distance = distance; last_width = width;
 			mem_clear_steps_cache();
 		}
 
 		int err;
-		if((err = memory_bandwidth_test(arg, access_fn)) < 0) {
+		if((err = memory_bandwidth_test(arg, memory_option)) < 0) {
 			_printf("WARNING: memory_bandwidth_test returned %d with datasize %d\n", j, err);
 			return NESTED_FOR_BREAK;
 		}
@@ -639,9 +1012,72 @@ void start_memory_bandwidth_benchmark(char *option) {
 		return 0;
 	}
 
+	// find knees of the bandwidth curve, measure more data sizes around
+	// them and print the inferred cache levels (every sweep separately)
+	int detect_cache_fn(unsigned level, iteration_var_t *vec) {
+		if(!config.memory.detect_cache) return 0;
+		unsigned i, k, j;
+		for(i=0; i<memory_curve.size; i++) {
+			memory_function_arg_t arg = memory_curve.points[i].arg;
+			bool analyzed = false;
+			for(j=0; j<i; j++) {
+				analyzed = analyzed || memory_curve_same_sweep(memory_curve.points[j].arg, arg);
+			}
+			if(analyzed) continue;
+
+			memory_knee_t knees[MEMORY_MAX_KNEES];
+			unsigned knee_count = memory_curve_knees(&memory_curve, arg, knees, MEMORY_MAX_KNEES);
+			mem_clear_steps_cache();
+			for(k=0; k<knee_count; k++) {
+				double ratio = (double)knees[k].above / knees[k].below;
+				for(j=1; j<=MEMORY_REFINE_POINTS; j++) {
+					arg.data_size = knees[k].below * pow(ratio, (double)j / (MEMORY_REFINE_POINTS + 1));
+					arg.data_size &= ~((unsigned_huge)CACHE_LINE_SIZE - 1);
+					if(arg.data_size <= knees[k].below || arg.data_size >= knees[k].above) continue;
+					memory_bandwidth_test(arg, memory_option);
+				}
+			}
+			mem_clear_steps_cache();
+			knee_count = memory_curve_knees(&memory_curve, arg, knees, MEMORY_MAX_KNEES);
+			memory_curve_print_levels(&memory_curve, arg, knees, knee_count);
+		}
+		memory_curve_clear(&memory_curve);
+		return 0;
+	}
+
 	// exit stride loop, if strides sizes are not supported (e.g. random)
 	int check_for_stride_fn(unsigned level, iteration_var_t *vec) {
-		if(!fn_uses_stride) return NESTED_FOR_BREAK;
+		if(!(fn_uses & MEMORY_USES_STRIDE)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit blocksize loop, if the access function doesn't use blocks (e.g. stream)
+	int check_for_blocksize_fn(unsigned level, iteration_var_t *vec) {
+		if(!(fn_uses & MEMORY_USES_BLOCKSIZE)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit distance loop, if the access function doesn't prefetch
+	int check_for_distance_fn(unsigned level, iteration_var_t *vec) {
+		if(!(fn_uses & MEMORY_USES_DISTANCE)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit width loop, if the access function has a fixed access width
+	int check_for_width_fn(unsigned level, iteration_var_t *vec) {
+		if(!(fn_uses & MEMORY_USES_WIDTH)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit chains loop, if the access function follows only one chain
+	int check_for_chains_fn(unsigned level, iteration_var_t *vec) {
+		if(!(fn_uses & MEMORY_USES_CHAINS)) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// exit thread loop, if only the main thread is used
+	int check_for_threads_fn(unsigned level, iteration_var_t *vec) {
+		if(memory_thread_mode == MEMORY_THREADS_SINGLE) return NESTED_FOR_BREAK;
 		return 0;
 	}
 
@@ -654,11 +1090,30 @@ void start_memory_bandwidth_benchmark(char *option) {
 	option_loop.inner_start_fn = &set_access_fn;
 	option_loop.outer_end_fn = &after_option_loop;
 
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+	thread_loop.inner_end_fn = &check_for_threads_fn;
+
+	for_loop_t cpu_node_loop = FOR_LOOP_T_INIT;
+	cpu_node_loop.var.name = "cpu node";
+	cpu_node_loop.var.start = 0;
+	cpu_node_loop.var.end = get_numa_node_count();
+	cpu_node_loop.step_fn = &step_increment;
+
+	for_loop_t mem_node_loop = FOR_LOOP_T_INIT;
+	mem_node_loop.var.name = "mem node";
+	mem_node_loop.var.start = 0;
+	mem_node_loop.var.end = get_numa_node_count();
+	mem_node_loop.step_fn = &step_increment;
+
 	for_loop_t range_loop = FOR_LOOP_T_INIT;
 	range_loop.var.name = "range";
 	range_loop.var.range = config.range;
 	range_loop.step_fn = &step_range;
 	range_loop.outer_start_fn = &print_header_fn;
+	range_loop.outer_end_fn = &detect_cache_fn;
 
 	for_loop_t stride_loop = FOR_LOOP_T_INIT;
 	stride_loop.var.name = "stride";
@@ -670,14 +1125,52 @@ void start_memory_bandwidth_benchmark(char *option) {
 	blocksize_loop.var.name = "blocksize";
 	blocksize_loop.var.range = config.memory.blocksize;
 	blocksize_loop.step_fn = &step_range;
-
-	option_loop.next = &range_loop;
+	blocksize_loop.inner_end_fn = &check_for_blocksize_fn;
+
+	for_loop_t distance_loop = FOR_LOOP_T_INIT;
+	distance_loop.var.name = "distance";
+	distance_loop.var.range = config.memory.distance;
+	distance_loop.step_fn = &step_range;
+	distance_loop.inner_end_fn = &check_for_distance_fn;
+
+	for_loop_t width_loop = FOR_LOOP_T_INIT;
+	width_loop.var.name = "width";
+	width_loop.var.range = config.memory.width;
+	width_loop.step_fn = &step_range;
+	width_loop.inner_end_fn = &check_for_width_fn;
+
+	for_loop_t chains_loop = FOR_LOOP_T_INIT;
+	chains_loop.var.name = "chains";
+	chains_loop.var.range = config.memory.chains;
+	chains_loop.step_fn = &step_range;
+	chains_loop.inner_end_fn = &check_for_chains_fn;
+
+	option_loop.next = &thread_loop;
+	if(config.memory.numa == NUMA_MATRIX) {
+		option_loop.next = &cpu_node_loop;
+		cpu_node_loop.next = &mem_node_loop;
+		mem_node_loop.next = &thread_loop;
+	}
+	thread_loop.next = &range_loop;
 	range_loop.next = &blocksize_loop;
 	blocksize_loop.next = &stride_loop;
+	stride_loop.next = &distance_loop;
+	distance_loop.next = &width_loop;
+	width_loop.next = &chains_loop;
+
+	// the matrix sweep pins the main thread, restore its mask afterwards
+	cpu_set_t main_cpu_set;
+	bool restore_cpu_set = config.memory.numa == NUMA_MATRIX
+			&& sched_getaffinity(0, sizeof(main_cpu_set), &main_cpu_set) == 0;
 
 	nested_for_loop(&option_loop, fn);
 
+	if(restore_cpu_set) {
+		sched_setaffinity(0, sizeof(main_cpu_set), &main_cpu_set);
+	}
+	memory_cpu_set_valid = false;
 	cache_clear_finish();
+	memory_buffer_free(&memory_buffer);
 	free(additional_info);
 }
 
@@ -697,6 +1190,17 @@ double median(double *array, int size) {
 	return array[middle];
 }
 
+/**
+ * value below which the fraction 'p' of the array lies (sorts the array)
+ */
+double percentile(double *array, int size, double p) {
+	if(size == 0) return NAN;
+	qsort(array, size, sizeof(double), compare);
+	int index = ceil(p * size) - 1;
+	index = index < 0 ? 0 : index >= size ? size - 1 : index;
+	return array[index];
+}
+
 statistic_t middle_stat(double *array, int size) {
 	statistic_t result = STATISTIC_T_INIT;
 	if(size == 0) return result;
@@ -715,23 +1219,40 @@ statistic_t middle_stat(double *array, int size) {
 /**
  * initialize buffer and repeat test function
  */
-int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
+int memory_bandwidth_test(memory_function_arg_t arg, memory_option_info_t *option)
 {
+	access_fn_t access_fn = option->access_fn;
 	unsigned_huge data_size = arg.data_size;
 	if(data_size == 0) return 1;
+	// every thread gets its own slice of data_size bytes
+	unsigned_huge buffer_size = data_size;
+	if(memory_thread_mode == MEMORY_THREADS_PRIVATE) {
+		buffer_size *= arg.threads;
+	}
 	// initializing
-	if(data_size > max_malloc_arg()){
-		_printf("cannot test memory bandwidth for %ld bytes, ", data_size);
+	if(buffer_size > max_malloc_arg()){
+		_printf("cannot test memory bandwidth for %ld bytes, ", buffer_size);
 		_printf("as there are only %ld available\n", max_malloc_arg());
 		return -1;
 	}
 
-	volatile void *buffer = NULL;
-	if(init_array(data_size, &buffer) != 0) {
-		_printf("WARNING: couldn't init %d bytes for memory benchmark\n", data_size);
+	// pages are touched first by the threads which access them
+	unsigned touch_threads = memory_thread_mode == MEMORY_THREADS_SINGLE ? 1 : arg.threads;
+	volatile void *buffer = memory_buffer_get(&memory_buffer, buffer_size, touch_threads, arg.mem_node);
+	if(buffer == NULL) {
+		_printf("WARNING: couldn't init %d bytes for memory benchmark\n", buffer_size);
 		return -1;
 	}
 	arg.buffer = buffer;
+	arg.page_size = memory_buffer.page_size;
+	if(option->init_fn != NULL) {
+		memory_function_arg_t init_arg = arg;
+		for(init_arg.buffer = buffer;
+				(volatile char *)init_arg.buffer < ((volatile char *)buffer) + buffer_size;
+				init_arg.buffer = ((volatile char *)init_arg.buffer) + data_size) {
+			option->init_fn(init_arg);
+		}
+	}
 	char *data_size_str = sprint_num_bytes(data_size);
 
 	unsigned_huge repetitions = mem_calculate_repetitions(arg, access_fn);
@@ -740,6 +1261,7 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	statistic_t stat_access_time = STATISTIC_T_INIT;
 	statistic_t stat_double = STATISTIC_T_INIT;
 	statistic_t stat_overhead = STATISTIC_T_INIT;
+	statistic_t stat_clear = STATISTIC_T_INIT;
 
 	statistic_t stat_bandwidth1 = STATISTIC_T_INIT;
 	statistic_t stat_bandwidth2 = STATISTIC_T_INIT;
@@ -756,10 +1278,9 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	int r;
 	for(r=0; r<config.warmup; r++) {
 		memory_result_t tmp_result = MEMORY_RESULT_T_INIT;
-		cache_clear();
 		arg.steps = steps;
 		arg.buffer = buffer;
-		tmp_result = access_fn(arg);
+		tmp_result = memory_access(arg, access_fn, NULL);
 		if(!tmp_result.datasize_enough) {
 			memory_result_t clean_result = MEMORY_RESULT_T_INIT;
 			tmp_result = clean_result;
@@ -775,10 +1296,11 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	for(r=0; r<repetitions; r++) {
 		memory_result_t empty_result = MEMORY_RESULT_T_INIT;
 		result[r] = empty_result;
-		cache_clear();
+		double clear_time;
 		arg.steps = steps;
 		arg.buffer = buffer;
-		result[r] = access_fn(arg);
+		result[r] = memory_access(arg, access_fn, &clear_time);
+		calculate_statistics_iterative(&stat_clear, clear_time);
 		blocksize = result[r].blocksize;
 		stride = result[r].stride;
 
@@ -803,6 +1325,13 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	free(time_overhead);
 
 	// print results
+	if(memory_thread_mode != MEMORY_THREADS_SINGLE) {
+		print_table_cell("%{threads}3u, ", arg.threads);
+	}
+	if(config.memory.numa == NUMA_MATRIX) {
+		print_table_cell("%{cpu node}3d, ", arg.cpu_node);
+		print_table_cell("%{mem node}3d, ", arg.mem_node);
+	}
 	print_table_cell("%{repetitions}5d, ", repetitions);
 	print_table_cell("%{steps}7Lu, ", steps);
 	print_table_cell("%{datasize}10Lu, ", data_size);
@@ -810,12 +1339,24 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 
 	print_table_cell("%{blocksize}6Lu, ", blocksize);
 	print_table_cell("%{stride}6Lu, ", stride);
+	if(option->uses & MEMORY_USES_DISTANCE) {
+		print_table_cell("%{distance}6Lu, ", arg.distance);
+	}
+	if(option->uses & MEMORY_USES_WIDTH) {
+		print_table_cell("%{width}6u, ", arg.width);
+	}
+	if(option->uses & MEMORY_USES_CHAINS) {
+		print_table_cell("%{chains}6u, ", arg.chains);
+	}
 
 	print_table_cell("%{step time}" PRECISSION "f, ", stat_access_time.mean/steps);
 	print_table_cell("%{step time deviation}" PRECISSION "f, ", stat_access_time.deviation/steps);
 
 	print_table_cell("%{overhead time}" PRECISSION "f, ", stat_overhead.mean/steps);
 	print_table_cell("%{overhead time deviation}" PRECISSION "f, ", stat_overhead.deviation/steps);
+	if(config.memory.cache_state != CACHE_STATE_WARM) {
+		print_table_cell("%{cache clear time}" PRECISSION "f, ", stat_clear.mean);
+	}
 
 	bandwidth = result[0].transmitted / (MB * (stat_access_time.mean - stat_overhead.mean));
 	if(bandwidth < 0) {
@@ -823,6 +1364,9 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	}
 	{
 	print_table_cell("%{bandwidth}" BIG_PRECISSION "f, ", bandwidth);
+	if(memory_thread_mode != MEMORY_THREADS_SINGLE) {
+		print_table_cell("%{bandwidth per thread}" BIG_PRECISSION "f, ", bandwidth / arg.threads);
+	}
 	// bandwidth deviation with gaussian error propagation
 	double diff = (stat_access_time.mean - stat_overhead.mean);
 	double factor = result[0].transmitted / MB / (diff * diff);
@@ -832,13 +1376,45 @@ int memory_bandwidth_test(memory_function_arg_t arg, access_fn_t access_fn)
 	print_table_cell("%{bandwidth deviation}" BIG_PRECISSION "f, ", bandwidth_deviation_gauss);
 	print_table_cell("%{sample size}4Lu, ", stat_access_time.sample_size);
 	}
+	double latency = NAN;
+	if(result[0].accesses > 0) {
+		// nanoseconds per dependent load of one chain, the accesses are
+		// summed up over all threads
+		double time = stat_access_time.mean - stat_overhead.mean;
+		latency = time * arg.threads * arg.chains / result[0].accesses * 1e9;
+		print_table_cell("%{latency ns}" PRECISSION "f, ", latency);
+		print_table_cell("%{cycles per access}" PRECISSION "f, ", latency * 1e-9 * get_cpu_frequency(-1));
+		// aggregate over all threads
+		print_table_cell("%{loads per ns}" PRECISSION "f, ", result[0].accesses / (time * 1e9));
+	}
+	if(option->uses & MEMORY_USES_DISTANCE) {
+		// gain over the hardware prefetcher alone, i.e. distance 0 of the same
+		// kernel and sweep point
+		static double baseline = NAN;
+		static memory_function_arg_t baseline_arg;
+		static memory_option_info_t *baseline_option = NULL;
+		if(option != baseline_option) {
+			baseline = NAN;
+			baseline_option = option;
+		}
+		if(arg.distance == 0) {
+			baseline = bandwidth;
+			baseline_arg = arg;
+		}
+		bool same_point = !isnan(baseline)
+				&& baseline_arg.data_size == arg.data_size
+				&& baseline_arg.stride == arg.stride && baseline_arg.threads == arg.threads
+				&& baseline_arg.cpu_node == arg.cpu_node && baseline_arg.mem_node == arg.mem_node;
+		print_table_cell("%{prefetch gain}" PRECISSION "f, ", same_point ? bandwidth / baseline : NAN);
+	}
+	if(config.memory.detect_cache) {
+		memory_curve_add(&memory_curve, arg, bandwidth, latency);
+	}
 	print_table_line();
 
 mem_bw_test_finish:
-	// free memory
-	free((void *)buffer);
+	// the buffer is kept for the next sweep point
 	free(data_size_str);
-	buffer = NULL;
 	if(!tmp_result.datasize_enough) return 0;
 	return 1;
 }
@@ -912,7 +1488,7 @@ unsigned mem_calculate_steps(
 		mem_calculate_steps(arg, access_fn);
 		arg.data_size = datasize;
 	}
-	if(cache_clear_stat.sample_size < 1) cache_clear();
+	if(cache_clear_stat.sample_size < 1) memory_cache_clear(arg.buffer, arg.data_size);
 
 	mem_index_steps_data = index;
 	int j;
@@ -921,7 +1497,7 @@ unsigned mem_calculate_steps(
 	int i, max_exp = 32;
 	double time;
 	for(i=0; i<max_exp; i++) {
-		cache_clear();
+		memory_cache_clear(arg.buffer, arg.data_size);
 		arg.steps = steps;
 		result = access_fn(arg);
 		time = result.time + result.overhead + cache_clear_stat.mean;
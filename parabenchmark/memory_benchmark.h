@@ -24,6 +24,13 @@
 
 #include "definitions.h"
 
+/**
+ * Variables for random number generator.
+ * See http://www.metachaos.net/resume/SampleCode3.html
+ */
+#define RANDOM_A 6364136223846793005
+#define RANDOM_C 1442695040888963407
+
 typedef struct {
 	unsigned_huge steps;
 	unsigned_huge data_size;
@@ -32,6 +39,15 @@ typedef struct {
 
 	volatile void *buffer;
 	bool uses_stride;
+	unsigned_huge page_size;	// page size of the allocation backend
+
+	unsigned threads;
+	unsigned chains;
+	unsigned_huge distance;	// prefetch distance in accesses
+	unsigned width;			// bytes per load/store instruction
+
+	int cpu_node;	// numa node of the accessing threads (matrix mode, else -1)
+	int mem_node;	// numa node of the buffer (-1: placement by first touch)
 } memory_function_arg_t;
 
 typedef struct {
@@ -46,19 +62,43 @@ typedef struct {
 
 	unsigned_huge blocksize;
 	unsigned_huge stride;
+
+	double accesses; // number of dependent loads (latency kernels only)
 } memory_result_t;
 
 #define MEMORY_RESULT_T_INIT {0.0, 0.0, 0.0, false}
 
 typedef memory_result_t (*access_fn_t)(memory_function_arg_t arg);
 
+/**
+ * how the buffer is distributed among the threads
+ */
+typedef enum {
+	MEMORY_THREADS_SINGLE,	// main thread only
+	MEMORY_THREADS_PRIVATE,	// every thread accesses its own slice
+	MEMORY_THREADS_SHARED	// all threads access the same buffer
+} memory_thread_mode_t;
+
+typedef void (*init_fn_t)(memory_function_arg_t arg);
+
+/**
+ * sweep dimensions, which are used by an access function
+ */
+#define MEMORY_USES_BLOCKSIZE	0x01
+#define MEMORY_USES_STRIDE		0x02
+#define MEMORY_USES_CHAINS		0x04
+#define MEMORY_USES_DISTANCE	0x08
+#define MEMORY_USES_WIDTH		0x10
+
 typedef struct {
 	char *name;
 	access_fn_t access_fn;
-	bool uses_stride;
+	unsigned uses;
+	init_fn_t init_fn; // initialize buffer (optional)
 } memory_option_info_t;
 
 void start_memory_bandwidth_benchmark(char *option);
+memory_option_info_t *memory_find_option(char *name);
 
 unsigned_huge max_malloc_arg();
 
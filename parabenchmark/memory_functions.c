@@ -0,0 +1,449 @@
+/*
+ * memory_functions.c
+ *
+ * Allocation of the memory benchmark buffer (malloc, mmap with populate,
+ * transparent or explicit huge pages), NUMA placement and parallel first
+ * touch.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_functions.h"
+#include "print_functions.h"
+#include "config.h"
+#include "system_info.h"
+#include "timer.h"
+#include <pthread.h>
+#include "pthread_functions.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cpuid.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define HUGE_PAGE_2M (2*1024*1024ULL)
+#define HUGE_PAGE_1G (1024*1024*1024ULL)
+
+/**
+ * memory policies of the kernel (see linux/mempolicy.h), used with the
+ * raw syscalls to avoid a dependency on libnuma
+ */
+#define MPOL_DEFAULT	0
+#define MPOL_BIND		2
+#define MPOL_INTERLEAVE	3
+
+#define NUMA_MAX_NODES 1024
+#define NUMA_MASK_BITS (8*sizeof(unsigned long))
+
+const char *memory_alloc_name(int alloc) {
+	switch(alloc) {
+	case ALLOC_MALLOC: return "malloc";
+	case ALLOC_POPULATE: return "populate";
+	case ALLOC_THP: return "thp";
+	case ALLOC_HUGETLB_2M: return "hugetlb2m";
+	case ALLOC_HUGETLB_1G: return "hugetlb1g";
+	}
+	return "unknown";
+}
+
+const char *memory_numa_name(int numa) {
+	switch(numa) {
+	case NUMA_FIRST_TOUCH: return "firsttouch";
+	case NUMA_LOCAL: return "local";
+	case NUMA_INTERLEAVE: return "interleave";
+	case NUMA_BIND: return "bind";
+	case NUMA_MATRIX: return "matrix";
+	}
+	return "unknown";
+}
+
+/**
+ * Memory policy and node mask for the buffer. Returns MPOL_DEFAULT if the
+ * placement is left to the first touch
+ */
+int numa_policy(memory_buffer_t *buf, unsigned long *mask) {
+	memset(mask, 0, NUMA_MAX_NODES/8);
+	if(buf->numa == NUMA_INTERLEAVE) {
+		unsigned i;
+		for(i=0; i<get_numa_node_count(); i++) {
+			int node = get_numa_node(i)->node_id;
+			mask[node / NUMA_MASK_BITS] |= 1UL << (node % NUMA_MASK_BITS);
+		}
+		return MPOL_INTERLEAVE;
+	}
+	if(buf->numa == NUMA_FIRST_TOUCH || buf->node < 0) return MPOL_DEFAULT;
+	if(buf->node >= NUMA_MAX_NODES) {
+		_printf("WARNING: numa node %d not valid\n", buf->node);
+		return MPOL_DEFAULT;
+	}
+	mask[buf->node / NUMA_MASK_BITS] |= 1UL << (buf->node % NUMA_MASK_BITS);
+	return MPOL_BIND;
+}
+
+/**
+ * set memory policy of the calling thread (for allocations which are
+ * faulted in by the kernel, i.e. MAP_POPULATE)
+ */
+void numa_set_thread_policy(memory_buffer_t *buf, bool set) {
+	unsigned long mask[NUMA_MAX_NODES/NUMA_MASK_BITS];
+	int mode = numa_policy(buf, mask);
+	if(mode == MPOL_DEFAULT) return;
+	if(!set) {
+		syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+	}
+	else if(syscall(SYS_set_mempolicy, mode, mask, NUMA_MAX_NODES) != 0) {
+		_printf("WARNING: set_mempolicy failed: %s\n", strerror(errno));
+	}
+}
+
+/**
+ * bind the pages of the buffer before they are touched
+ */
+void numa_bind_buffer(memory_buffer_t *buf) {
+	unsigned long mask[NUMA_MAX_NODES/NUMA_MASK_BITS];
+	int mode = numa_policy(buf, mask);
+	if(mode == MPOL_DEFAULT) return;
+	// mbind needs page aligned addresses (malloc doesn't return them)
+	uintptr_t page_size = sysconf(_SC_PAGESIZE);
+	uintptr_t start = ((uintptr_t)buf->ptr + page_size - 1) & ~(page_size - 1);
+	uintptr_t end = ((uintptr_t)buf->ptr + buf->size) & ~(page_size - 1);
+	if(end <= start) return;
+	if(syscall(SYS_mbind, start, end - start, mode, mask, NUMA_MAX_NODES, 0) != 0) {
+		_printf("WARNING: mbind failed: %s\n", strerror(errno));
+	}
+}
+
+unsigned_huge round_up(unsigned_huge size, unsigned_huge page_size) {
+	return (size + page_size - 1) / page_size * page_size;
+}
+
+/**
+ * anonymous mapping aligned to 'alignment' (needed for transparent huge pages)
+ */
+void *mmap_aligned(unsigned_huge size, unsigned_huge alignment) {
+	char *ptr = mmap(NULL, size + alignment, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(ptr == MAP_FAILED) return NULL;
+	uintptr_t start = (uintptr_t)ptr;
+	uintptr_t aligned = (start + alignment - 1) & ~((uintptr_t)alignment - 1);
+	if(aligned > start) munmap(ptr, aligned - start);
+	if(start + alignment > aligned) {
+		munmap((void *)(aligned + size), start + alignment - aligned);
+	}
+	return (void *)aligned;
+}
+
+/**
+ * allocate at least 'size' bytes with the configured backend
+ */
+bool memory_buffer_alloc(memory_buffer_t *buf, unsigned_huge size) {
+	void *ptr = NULL;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	buf->alloc = config.memory.alloc;
+	buf->page_size = sysconf(_SC_PAGESIZE);
+	buf->mapped = round_up(size, buf->page_size);
+
+	switch(buf->alloc) {
+	case ALLOC_MALLOC:
+		ptr = malloc(size);
+		break;
+	case ALLOC_POPULATE:
+		// the pages are faulted in by the calling thread
+		numa_set_thread_policy(buf, true);
+		ptr = mmap(NULL, buf->mapped, PROT_READ | PROT_WRITE, flags | MAP_POPULATE, -1, 0);
+		numa_set_thread_policy(buf, false);
+		break;
+	case ALLOC_THP:
+		buf->mapped = round_up(size, HUGE_PAGE_2M);
+		ptr = mmap_aligned(buf->mapped, HUGE_PAGE_2M);
+		if(ptr == NULL) break;
+		if(madvise(ptr, buf->mapped, MADV_HUGEPAGE) != 0) {
+			_printf("WARNING: madvise(MADV_HUGEPAGE) failed: %s\n", strerror(errno));
+		}
+		else {
+			buf->page_size = HUGE_PAGE_2M;
+		}
+		break;
+	case ALLOC_HUGETLB_2M:
+		buf->page_size = HUGE_PAGE_2M;
+		buf->mapped = round_up(size, buf->page_size);
+		ptr = mmap(NULL, buf->mapped, PROT_READ | PROT_WRITE,
+				flags | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+		break;
+	case ALLOC_HUGETLB_1G:
+		buf->page_size = HUGE_PAGE_1G;
+		buf->mapped = round_up(size, buf->page_size);
+		ptr = mmap(NULL, buf->mapped, PROT_READ | PROT_WRITE,
+				flags | MAP_HUGETLB | MAP_HUGE_1GB, -1, 0);
+		break;
+	}
+	if(ptr == MAP_FAILED || ptr == NULL) {
+		_printf("WARNING: %s allocation of %Lu bytes failed: %s\n",
+				memory_alloc_name(buf->alloc), size, strerror(errno));
+		buf->ptr = NULL;
+		buf->size = 0;
+		buf->mapped = 0;
+		return false;
+	}
+	buf->ptr = ptr;
+	buf->size = size;
+	return true;
+}
+
+void memory_buffer_free(memory_buffer_t *buf) {
+	if(buf->ptr == NULL) return;
+	if(buf->alloc == ALLOC_MALLOC) {
+		free((void *)buf->ptr);
+	}
+	else {
+		munmap((void *)buf->ptr, buf->mapped);
+	}
+	buf->ptr = NULL;
+	buf->size = 0;
+	buf->mapped = 0;
+}
+
+/**
+ * Return a buffer of at least 'size' bytes. The buffer of the last call is
+ * reused, if it is large enough and was placed and first touched the same
+ * way (policy, node and number of threads). New buffers are
+ * placed according to config.memory.numa ('mem_node' is used by the local,
+ * bind and matrix policies) and pre-faulted by 'touch_threads' threads, so
+ * that with first touch the pages are local to the threads which access
+ * them later
+ */
+volatile void *memory_buffer_get(memory_buffer_t *buf, unsigned_huge size,
+		unsigned touch_threads, int mem_node) {
+	if(buf->ptr != NULL && buf->size >= size && buf->alloc == config.memory.alloc
+			&& buf->numa == config.memory.numa && buf->node == mem_node
+			&& buf->touch_threads == touch_threads) {
+		return buf->ptr;
+	}
+	// the pages stay where they were first touched, so allocate anew
+	memory_buffer_free(buf);
+	buf->numa = config.memory.numa;
+	buf->node = mem_node;
+	buf->touch_threads = touch_threads;
+	if(!memory_buffer_alloc(buf, size)) return NULL;
+	if(buf->alloc != ALLOC_POPULATE) {
+		numa_bind_buffer(buf);
+		memory_first_touch(buf->ptr, buf->size, touch_threads);
+	}
+	return buf->ptr;
+}
+
+typedef struct {
+	volatile char *start;
+	unsigned_huge size;
+	unsigned_huge page_size;
+} memory_touch_data_t;
+
+void *memory_touch_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	memory_touch_data_t *data = (memory_touch_data_t*) arg->data;
+	unsigned_huge i;
+	for(i=0; i<data->size; i+=data->page_size) {
+		data->start[i] = 0;
+	}
+	return (void *)NULL;
+}
+
+/**
+ * write one byte per page, every thread touches a contiguous chunk
+ */
+void memory_first_touch(volatile void *ptr, unsigned_huge size, unsigned threads) {
+	unsigned_huge page_size = sysconf(_SC_PAGESIZE);
+	unsigned_huge pages = (size + page_size - 1) / page_size;
+	if(threads > pages) threads = pages;
+	if(threads == 0) return;
+
+	thread_arg_t *args = threads > 1 ? get_thread_array(threads) : NULL;
+	if(args == NULL) {
+		// touch in the calling thread
+		memory_touch_data_t data = {(volatile char *)ptr, size, page_size};
+		thread_arg_t arg = THREAD_ARG_T_INIT;
+		arg.data = &data;
+		memory_touch_loop(&arg);
+		return;
+	}
+
+	memory_touch_data_t data[threads];
+	unsigned_huge chunk = (pages + threads - 1) / threads * page_size;
+	unsigned i;
+	for(i=0; i<threads; i++) {
+		unsigned_huge start = i*chunk;
+		data[i].start = ((volatile char *)ptr) + start;
+		data[i].size = start >= size ? 0 : (size - start < chunk ? size - start : chunk);
+		data[i].page_size = page_size;
+		args[i].reduce = false;
+		args[i].thread_count = threads;
+		args[i].loop_function = &memory_touch_loop;
+		args[i].data = &data[i];
+	}
+
+	threads_prepare(args, threads);
+	threads_start(args, threads);
+	threads_join(args, threads);
+}
+
+const char *memory_cache_state_name(int cache_state) {
+	switch(cache_state) {
+	case CACHE_STATE_WARM: return "warm";
+	case CACHE_STATE_FLUSH: return "flush";
+	case CACHE_STATE_EVICT: return "evict";
+	case CACHE_STATE_FULL: return "full";
+	}
+	return "unknown";
+}
+
+/**
+ * Twice the sum of the data and unified caches of processor 0, so that
+ * the eviction buffer also replaces victim (non-inclusive) caches. Falls
+ * back to config.memory.cache_clean_size if the caches are unknown
+ */
+unsigned_huge cache_eviction_size() {
+	unsigned_huge size = 0;
+	unsigned i;
+	for(i=0; i<get_cache_count(); i++) {
+		cache_info_t *cache = get_cache_info(i);
+		if(cache->type != NULL && strcmp(cache->type, "Instruction") == 0) continue;
+		size += cache->size;
+	}
+	return size == 0 ? config.memory.cache_clean_size : 2*size;
+}
+
+volatile char *cache_eviction_buffer = NULL;
+unsigned_huge cache_eviction_buffer_size = 0;
+
+void cache_clear_init() {
+	if(config.memory.cache_state != CACHE_STATE_EVICT
+			&& config.memory.cache_state != CACHE_STATE_FULL) return;
+	cache_eviction_buffer_size = cache_eviction_size();
+	cache_eviction_buffer = (volatile char *)malloc(cache_eviction_buffer_size);
+	if(cache_eviction_buffer == NULL) {
+		_printf("WARNING: cache clear couldn't allocate %Lu bytes\n", cache_eviction_buffer_size);
+		return;
+	}
+	memset((void *)cache_eviction_buffer, 1, cache_eviction_buffer_size);
+}
+
+bool cache_clflushopt_supported() {
+	unsigned eax, ebx, ecx, edx;
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+	return (ebx & (1 << 23)) != 0;
+}
+
+/**
+ * write back and invalidate every cache line of the buffer
+ */
+void cache_flush(volatile void *buffer, unsigned_huge size) {
+	static int clflushopt = -1;
+	if(clflushopt == -1) clflushopt = cache_clflushopt_supported();
+	if(buffer == NULL || size == 0) return;
+	volatile char *p = (volatile char *)((uintptr_t)buffer & ~(uintptr_t)63);
+	volatile char *end = (volatile char *)buffer + size;
+	if(clflushopt) {
+		asm volatile (
+			"1:"
+			"clflushopt (%[p]);"
+			"add $64, %[p];"
+			"cmp %[end], %[p];"
+			"jb 1b;"
+			"mfence;"
+			: [p] "+r" (p)
+			: [end] "r" (end)
+			: "cc", "memory"
+		);
+	}
+	else {
+		asm volatile (
+			"1:"
+			"clflush (%[p]);"
+			"add $64, %[p];"
+			"cmp %[end], %[p];"
+			"jb 1b;"
+			"mfence;"
+			: [p] "+r" (p)
+			: [end] "r" (end)
+			: "cc", "memory"
+		);
+	}
+}
+
+/**
+ * load one word per cache line of the eviction buffer
+ */
+void cache_evict() {
+	if(cache_eviction_buffer == NULL) return;
+	volatile char *p = cache_eviction_buffer;
+	volatile char *end = cache_eviction_buffer + cache_eviction_buffer_size;
+	asm volatile (
+		"1:"
+		"mov (%[p]), %%rax;"
+		"add $64, %[p];"
+		"cmp %[end], %[p];"
+		"jb 1b;"
+		: [p] "+r" (p)
+		: [end] "r" (end)
+		: "rax", "cc", "memory"
+	);
+}
+
+/**
+ * Bring the caches into the configured state before a measurement of
+ * 'buffer'. Returns the time it took
+ */
+double cache_clear(volatile void *buffer, unsigned_huge size) {
+	tick_thread(MODE_START);
+	switch(config.memory.cache_state) {
+	case CACHE_STATE_WARM:
+		break;
+	case CACHE_STATE_FLUSH:
+		cache_flush(buffer, size);
+		break;
+	case CACHE_STATE_EVICT:
+		cache_evict();
+		break;
+	case CACHE_STATE_FULL:
+		// the flushed eviction buffer leaves no valid lines behind
+		cache_evict();
+		cache_flush(cache_eviction_buffer, cache_eviction_buffer_size);
+		cache_flush(buffer, size);
+		break;
+	}
+	return tick_thread(MODE_END);
+}
+
+void cache_clear_finish() {
+	free((void *)cache_eviction_buffer);
+	cache_eviction_buffer = NULL;
+	cache_eviction_buffer_size = 0;
+}
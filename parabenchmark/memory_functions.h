@@ -0,0 +1,59 @@
+/*
+ * memory_functions.h
+ *
+ * Allocation of the memory benchmark buffer (malloc, mmap with populate,
+ * transparent or explicit huge pages), NUMA placement and parallel first
+ * touch.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_FUNCTIONS_H
+#define __MEMORY_FUNCTIONS_H
+
+#include "definitions.h"
+
+/**
+ * buffer, which is reused as long as it is large enough
+ */
+typedef struct {
+	volatile void *ptr;
+	unsigned_huge size;			// usable size
+	unsigned_huge mapped;		// size of the mapping (multiple of page size)
+	unsigned_huge page_size;
+	int alloc;					// allocation backend, see config.memory.alloc
+	int numa;					// placement policy, see config.memory.numa
+	int node;					// memory node of the policy (-1: none)
+	unsigned touch_threads;		// number of threads of the first touch
+} memory_buffer_t;
+
+#define MEMORY_BUFFER_T_INIT {NULL, 0, 0, 0, 0, 0, -1, 0}
+
+const char *memory_alloc_name(int alloc);
+const char *memory_numa_name(int numa);
+
+volatile void *memory_buffer_get(memory_buffer_t *buf, unsigned_huge size,
+		unsigned touch_threads, int mem_node);
+void memory_buffer_free(memory_buffer_t *buf);
+void memory_first_touch(volatile void *ptr, unsigned_huge size, unsigned threads);
+
+const char *memory_cache_state_name(int cache_state);
+unsigned_huge cache_eviction_size();
+void cache_clear_init();
+double cache_clear(volatile void *buffer, unsigned_huge size);
+void cache_clear_finish();
+
+#endif
@@ -0,0 +1,203 @@
+/*
+ * memory_hierarchy.c
+ *
+ * Infer the cache hierarchy from the knees of the bandwidth curve of a
+ * data size sweep and compare it with the caches reported by the kernel.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_hierarchy.h"
+#include "print_functions.h"
+#include "system_info.h"
+
+/**
+ * bandwidth ratio of two neighboring data sizes, which is considered as
+ * the transition to the next level of the memory hierarchy
+ */
+#define KNEE_RATIO 1.3
+
+void memory_curve_add(memory_curve_t *curve, memory_function_arg_t arg,
+		double bandwidth, double latency) {
+	curve->points = (memory_point_t*)realloc(curve->points,
+			(curve->size + 1) * sizeof(memory_point_t));
+	arg.buffer = NULL;
+	curve->points[curve->size].arg = arg;
+	curve->points[curve->size].bandwidth = bandwidth;
+	curve->points[curve->size].latency = latency;
+	curve->size++;
+}
+
+void memory_curve_clear(memory_curve_t *curve) {
+	free(curve->points);
+	curve->points = NULL;
+	curve->size = 0;
+}
+
+/**
+ * points belong to the same sweep, if only the data size differs
+ */
+bool memory_curve_same_sweep(memory_function_arg_t a, memory_function_arg_t b) {
+	return a.blocksize == b.blocksize && a.stride == b.stride
+			&& a.chains == b.chains && a.distance == b.distance && a.width == b.width && a.threads == b.threads;
+}
+
+int compare_points(const void *a, const void *b) {
+	unsigned_huge size_a = ((memory_point_t*)a)->arg.data_size;
+	unsigned_huge size_b = ((memory_point_t*)b)->arg.data_size;
+	return size_a > size_b ? 1 : size_a < size_b ? -1 : 0;
+}
+
+/**
+ * copy the points of one sweep, sorted by data size
+ */
+unsigned sweep_points(memory_curve_t *curve, memory_function_arg_t arg, memory_point_t **points) {
+	*points = (memory_point_t*)malloc((curve->size + 1) * sizeof(memory_point_t));
+	unsigned i, size = 0;
+	for(i=0; i<curve->size; i++) {
+		if(!memory_curve_same_sweep(curve->points[i].arg, arg)) continue;
+		if(isnan(curve->points[i].bandwidth)) continue;
+		(*points)[size++] = curve->points[i];
+	}
+	qsort(*points, size, sizeof(memory_point_t), compare_points);
+	return size;
+}
+
+/**
+ * Find the data sizes where the bandwidth drops by more than KNEE_RATIO.
+ * Consecutive drops are merged, as the transition of the shared last level
+ * cache is usually spread over several sizes. Returns the number of knees
+ */
+unsigned memory_curve_knees(memory_curve_t *curve, memory_function_arg_t arg,
+		memory_knee_t *knees, unsigned max_knees) {
+	memory_point_t *points;
+	unsigned size = sweep_points(curve, arg, &points);
+	unsigned i, count = 0;
+	bool in_knee = false;
+	for(i=0; i+1<size; i++) {
+		bool drop = points[i].bandwidth > KNEE_RATIO * points[i+1].bandwidth;
+		if(drop && in_knee) {
+			knees[count-1].above = points[i+1].arg.data_size;
+		}
+		else if(drop && count < max_knees) {
+			knees[count].below = points[i].arg.data_size;
+			knees[count].above = points[i+1].arg.data_size;
+			count++;
+		}
+		in_knee = drop;
+	}
+	free(points);
+	return count;
+}
+
+double median_of(double *values, unsigned size) {
+	if(size == 0) return NAN;
+	unsigned i, j;
+	for(i=1; i<size; i++) {
+		for(j=i; j>0 && values[j-1] > values[j]; j--) {
+			double tmp = values[j]; values[j] = values[j-1]; values[j-1] = tmp;
+		}
+	}
+	return values[size/2];
+}
+
+/**
+ * data or unified cache reported by the kernel, whose size is nearest to
+ * the knee (on a logarithmic scale). NULL if there is none
+ */
+cache_info_t *sys_nearest_cache(memory_knee_t knee) {
+	double center = log(knee.below) + log(knee.above);
+	cache_info_t *result = NULL;
+	double best = INFINITY;
+	unsigned i;
+	for(i=0; i<get_cache_count(); i++) {
+		cache_info_t *cache = get_cache_info(i);
+		if(strcmp(cache->type, "Instruction") == 0 || cache->size == 0) continue;
+		double distance = fabs(2*log(cache->size) - center);
+		if(distance < best) {
+			best = distance;
+			result = cache;
+		}
+	}
+	return result;
+}
+
+/**
+ * Print the inferred levels: capacity, bandwidth and latency (median of the
+ * plateau between two knees) and the nearest cache reported by the kernel.
+ * The levels are only counted, as the sweep may start beyond the L1 cache
+ */
+void memory_curve_print_levels(memory_curve_t *curve, memory_function_arg_t arg,
+		memory_knee_t *knees, unsigned knee_count) {
+	memory_point_t *points;
+	unsigned size = sweep_points(curve, arg, &points);
+	double bandwidth[size + 1], latency[size + 1];
+
+	_printf("inferred memory hierarchy (threads %u", arg.threads);
+	if(arg.blocksize != 0) _printf(", blocksize %Lu", arg.blocksize);
+	if(arg.stride != 0) _printf(", stride %ld", arg.stride);
+	if(arg.chains > 1) _printf(", chains %u", arg.chains);
+	if(arg.distance != 0) _printf(", distance %Lu", arg.distance);
+	if(arg.width != 0) _printf(", width %u", arg.width);
+	_printf("):\n");
+	unsigned level, i = 0;
+	for(level=0; level<=knee_count; level++) {
+		// plateau of this level
+		unsigned n = 0, n_latency = 0;
+		for(; i<size; i++) {
+			unsigned_huge data_size = points[i].arg.data_size;
+			if(level < knee_count && data_size > knees[level].below) break;
+			if(level > 0 && data_size < knees[level-1].above) continue;
+			bandwidth[n++] = points[i].bandwidth;
+			if(!isnan(points[i].latency)) latency[n_latency++] = points[i].latency;
+		}
+		double level_bandwidth = median_of(bandwidth, n);
+		double level_latency = median_of(latency, n_latency);
+
+		if(level == knee_count) {
+			_printf("\tmemory: bandwidth=%.1f", level_bandwidth);
+		}
+		else {
+			char *below = sprint_num_bytes(knees[level].below);
+			char *above = sprint_num_bytes(knees[level].above);
+			_printf("\tlevel %u: capacity between %s and %s, bandwidth=%.1f",
+					level + 1, below, above, level_bandwidth);
+			free(below);
+			free(above);
+		}
+		if(!isnan(level_latency)) _printf(", latency ns=%.2f", level_latency);
+
+		cache_info_t *cache = level < knee_count ? sys_nearest_cache(knees[level]) : NULL;
+		if(cache != NULL) {
+			char *cache_size = sprint_num_bytes(cache->size);
+			bool match = knees[level].below <= cache->size && cache->size <= knees[level].above;
+			_printf("; sysfs L%d %s %s (%s)", cache->level, cache->type, cache_size,
+					match ? "matches" : "differs");
+			free(cache_size);
+		}
+		_printf(";\n");
+	}
+	unsigned sys_levels = 0;
+	for(i=0; i<get_cache_count(); i++) {
+		if(strcmp(get_cache_info(i)->type, "Instruction") != 0) sys_levels++;
+	}
+	if(sys_levels > knee_count) {
+		_printf("\tWARNING: sysfs reports %u cache levels, but only %u were detected "
+				"(extend the range)\n", sys_levels, knee_count);
+	}
+	free(points);
+}
@@ -0,0 +1,63 @@
+/*
+ * memory_hierarchy.h
+ *
+ * Infer the cache hierarchy from the knees of the bandwidth curve of a
+ * data size sweep and compare it with the caches reported by the kernel.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_HIERARCHY_H
+#define __MEMORY_HIERARCHY_H
+
+#include "definitions.h"
+#include "memory_benchmark.h"
+
+typedef struct {
+	memory_function_arg_t arg;	// data size and the other sweep dimensions
+	double bandwidth;
+	double latency;				// NAN if not measured
+} memory_point_t;
+
+typedef struct {
+	memory_point_t *points;
+	unsigned size;
+} memory_curve_t;
+
+#define MEMORY_CURVE_T_INIT {NULL, 0}
+
+/**
+ * drop of the bandwidth between two data sizes (the capacity of a cache
+ * level lies in between)
+ */
+typedef struct {
+	unsigned_huge below;
+	unsigned_huge above;
+} memory_knee_t;
+
+#define MEMORY_MAX_KNEES 8
+
+void memory_curve_add(memory_curve_t *curve, memory_function_arg_t arg,
+		double bandwidth, double latency);
+void memory_curve_clear(memory_curve_t *curve);
+bool memory_curve_same_sweep(memory_function_arg_t a, memory_function_arg_t b);
+
+unsigned memory_curve_knees(memory_curve_t *curve, memory_function_arg_t arg,
+		memory_knee_t *knees, unsigned max_knees);
+void memory_curve_print_levels(memory_curve_t *curve, memory_function_arg_t arg,
+		memory_knee_t *knees, unsigned knee_count);
+
+#endif
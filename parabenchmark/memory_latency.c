@@ -0,0 +1,212 @@
+/*
+ * memory_latency.c
+ *
+ * Memory kernels measuring the load-to-use latency by following a chain of
+ * pointers through a randomized cyclic permutation.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_latency.h"
+#include "memory_benchmark.h"
+#include "print_functions.h"
+#include "timer.h"
+#include <stdint.h>
+#include <sched.h>
+
+/**
+ * Offset of an element inside its granule. For granules larger than a
+ * cache line a pseudo random line is chosen, otherwise all elements would
+ * map to the same cache set
+ */
+unsigned_huge chase_element_offset(unsigned_huge index, unsigned_huge granularity) {
+	if(granularity <= CACHE_LINE_SIZE) return 0;
+	unsigned_huge x = RANDOM_A*(index+1) + RANDOM_C;
+	return ((x >> 16) % (granularity / CACHE_LINE_SIZE)) * CACHE_LINE_SIZE;
+}
+
+void **chase_element(memory_function_arg_t arg, unsigned_huge index, unsigned_huge granularity) {
+	return (void **)((char *)arg.buffer + index*granularity
+			+ chase_element_offset(index, granularity));
+}
+
+/**
+ * Pseudo random permutation of [0, n): a Feistel network on the next even
+ * power of two with cycle walking. Maps position in the chain to element
+ */
+unsigned_huge chase_permute(unsigned_huge x, unsigned_huge n) {
+	unsigned half = 1;
+	while((1ULL << (2*half)) < n) half++;
+	unsigned_huge mask = (1ULL << half) - 1;
+	do {
+		unsigned_huge l = x >> half, r = x & mask;
+		int round;
+		for(round=0; round<4; round++) {
+			unsigned_huge f = ((r ^ (round * RANDOM_C)) * RANDOM_A + RANDOM_C) >> (64 - half);
+			unsigned_huge tmp = l ^ f;
+			l = r;
+			r = tmp;
+		}
+		x = (l << half) | r;
+	} while(x >= n);
+	return x;
+}
+
+/**
+ * Link one element per granule to a single cycle in random order, so that
+ * neither the hardware prefetcher nor the out-of-order execution can hide
+ * the latency. Position q of the cycle is element chase_permute(q, n)
+ */
+void chase_init(memory_function_arg_t arg, unsigned_huge granularity) {
+	unsigned_huge n = arg.data_size / granularity;
+	if(n < 2) return;
+
+	unsigned_huge q;
+	unsigned_huge act = chase_permute(0, n), first = act;
+	for(q=1; q<n; q++) {
+		unsigned_huge next = chase_permute(q, n);
+		*chase_element(arg, act, granularity) = (void *)chase_element(arg, next, granularity);
+		act = next;
+	}
+	*chase_element(arg, act, granularity) = (void *)chase_element(arg, first, granularity);
+}
+
+void chase_line_init(memory_function_arg_t arg) {
+	chase_init(arg, CACHE_LINE_SIZE);
+}
+
+void chase_page_init(memory_function_arg_t arg) {
+	chase_init(arg, PAGE_SIZE_4K);
+}
+
+/**
+ * One element per page of the allocation backend (4K, 2M or 1G), so that
+ * every access needs a different TLB entry
+ */
+void chase_tlb_init(memory_function_arg_t arg) {
+	chase_init(arg, arg.page_size);
+}
+
+/**
+ * Follow the pointer chain. One step visits every element once
+ */
+memory_result_t chase_test(memory_function_arg_t arg, unsigned_huge granularity) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	unsigned_huge n = arg.data_size / granularity;
+	if(n < 2) {
+		result.datasize_enough = false;
+		return result;
+	}
+
+	void **p = chase_element(arg, chase_permute(0, n), granularity);
+	unsigned_huge step = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step-->0) {
+		unsigned_huge i = n;
+		asm volatile (
+			"1:"
+			"mov (%[p]), %[p];"
+			"dec %[i];"
+			"jnz 1b;"
+			: [p] "+r" (p), [i] "+r" (i)
+			:
+			: "cc", "memory"
+		);
+	}
+	result.time = tick_thread(MODE_END);
+	// the loop instructions execute in the shadow of the load latency
+	result.overhead = 0;
+
+	result.accesses = arg.steps * ((double) n);
+	result.transmitted = result.accesses * sizeof(void *);
+	result.datasize_enough = true;
+	result.blocksize = granularity;
+	result.stride = 0;
+	return result;
+}
+
+memory_result_t test_chase_line(memory_function_arg_t arg) {
+	return chase_test(arg, CACHE_LINE_SIZE);
+}
+
+memory_result_t test_chase_page(memory_function_arg_t arg) {
+	return chase_test(arg, PAGE_SIZE_4K);
+}
+
+memory_result_t test_chase_tlb(memory_function_arg_t arg) {
+	return chase_test(arg, arg.page_size);
+}
+
+/**
+ * Follow 'arg.chains' independent parts of the chain interleaved in one
+ * loop, to measure how many outstanding misses the core sustains. The
+ * chain pointers are kept in a small (L1 resident) array
+ */
+memory_result_t test_mlp(memory_function_arg_t arg) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	unsigned_huge chains = arg.chains;
+	unsigned_huge n = arg.data_size / CACHE_LINE_SIZE;
+	if(chains == 0 || n < 2*chains) {
+		result.datasize_enough = false;
+		return result;
+	}
+	unsigned_huge length = n / chains;
+
+	void **start[chains], **p[chains];
+	unsigned_huge j;
+	for(j=0; j<chains; j++) {
+		start[j] = chase_element(arg, chase_permute(j*length, n), CACHE_LINE_SIZE);
+		p[j] = start[j];
+	}
+
+	unsigned_huge step = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step-->0) {
+		unsigned_huge i = length;
+		asm volatile (
+			"1:"
+			"xor %%rcx, %%rcx;"
+			"2:"
+			"mov (%[p],%%rcx,8), %%rax;"
+			"mov (%%rax), %%rax;"
+			"mov %%rax, (%[p],%%rcx,8);"
+			"inc %%rcx;"
+			"cmp %[chains], %%rcx;"
+			"jb 2b;"
+			"dec %[i];"
+			"jnz 1b;"
+			: [i] "+r" (i)
+			: [p] "r" (p), [chains] "r" (chains)
+			: "rax", "rcx", "cc", "memory"
+		);
+		// continue where the chain parts started, to visit the same elements
+		for(j=0; j<chains; j++) {
+			p[j] = start[j];
+		}
+	}
+	result.time = tick_thread(MODE_END);
+	result.overhead = 0;
+
+	result.accesses = arg.steps * ((double) length) * chains;
+	result.transmitted = result.accesses * sizeof(void *);
+	result.datasize_enough = true;
+	result.blocksize = CACHE_LINE_SIZE;
+	result.stride = 0;
+	return result;
+}
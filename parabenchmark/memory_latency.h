@@ -0,0 +1,41 @@
+/*
+ * memory_latency.h
+ *
+ * Memory kernels measuring the load-to-use latency by following a chain of
+ * pointers through a randomized cyclic permutation.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_LATENCY_H
+#define __MEMORY_LATENCY_H
+
+#include "definitions.h"
+#include "memory_benchmark.h"
+
+#define CACHE_LINE_SIZE 64
+#define PAGE_SIZE_4K 4096
+
+void chase_line_init(memory_function_arg_t arg);
+void chase_page_init(memory_function_arg_t arg);
+void chase_tlb_init(memory_function_arg_t arg);
+
+memory_result_t test_chase_line(memory_function_arg_t arg);
+memory_result_t test_chase_page(memory_function_arg_t arg);
+memory_result_t test_chase_tlb(memory_function_arg_t arg);
+memory_result_t test_mlp(memory_function_arg_t arg);
+
+#endif
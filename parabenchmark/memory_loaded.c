@@ -0,0 +1,285 @@
+/*
+ * memory_loaded.c
+ *
+ * Loaded latency: pointer chasing latency while other threads run a
+ * bandwidth kernel at full speed.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "memory_benchmark.h"
+#include "memory_latency.h"
+#include "memory_functions.h"
+#include "memory_loaded.h"
+#include "system_info.h"
+#include "parse.h"
+#include "nested_for.h"
+#include "pthread_functions.h"
+
+#define __USE_GNU
+#include <sched.h>
+#include <pthread.h>
+
+extern config_t config;
+
+/**
+ * width of the access width kernels, SSE2 is available on every x86-64
+ */
+#define LOADED_WIDTH 16
+
+typedef struct {
+	volatile int started;	// number of load threads running
+	volatile int stop;		// set by the latency thread when it is finished
+} loaded_control_t;
+
+typedef struct {
+	memory_function_arg_t arg;
+	access_fn_t access_fn;
+	loaded_control_t *control;
+
+	// load threads: transmitted bytes and time
+	double transmitted;
+	double time;
+	bool datasize_enough;
+
+	// latency thread: seconds per load of every repetition
+	double *latency;
+	int repetitions;
+	int load_threads;
+} loaded_thread_data_t;
+
+/**
+ * run the bandwidth kernel until the latency thread is finished
+ */
+void *loaded_load_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	loaded_thread_data_t *data = (loaded_thread_data_t*) arg->data;
+	data->transmitted = 0;
+	data->time = 0;
+	data->datasize_enough = true;
+	bool first = true;
+	while(!data->control->stop) {
+		memory_result_t result = data->access_fn(data->arg);
+		if(first) {
+			__sync_fetch_and_add(&data->control->started, 1);
+			first = false;
+		}
+		if(!result.datasize_enough) {
+			data->datasize_enough = false;
+			break;
+		}
+		data->transmitted += result.transmitted;
+		data->time += result.time;
+	}
+	return (void *)NULL;
+}
+
+/**
+ * wait for the load threads, then measure the latency 'repetitions' times
+ */
+void *loaded_latency_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	loaded_thread_data_t *data = (loaded_thread_data_t*) arg->data;
+	// stay on one processor, if no thread affinity is configured. The pool
+	// thread is shared with other tests, so its mask is restored at the end
+	cpu_set_t old_mask;
+	bool restore = config.thread_affinity == AFFINITY_NONE
+			&& pthread_getaffinity_np(pthread_self(), sizeof(old_mask), &old_mask) == 0;
+	if(config.thread_affinity == AFFINITY_NONE) {
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(sched_getcpu(), &mask);
+		pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+	}
+	while(data->control->started < data->load_threads) {
+		sched_yield();
+	}
+	int r;
+	for(r=0; r<data->repetitions; r++) {
+		memory_result_t result = test_chase_line(data->arg);
+		data->latency[r] = result.datasize_enough ? result.time / result.accesses : NAN;
+	}
+	data->control->stop = 1;
+	if(restore) {
+		pthread_setaffinity_np(pthread_self(), sizeof(old_mask), &old_mask);
+	}
+	return (void *)NULL;
+}
+
+memory_buffer_t loaded_buffer = MEMORY_BUFFER_T_INIT;
+
+/**
+ * Pool thread 0 chases pointers through its own 'data_size' bytes, while
+ * pool threads 1 to 'load_threads' run the load kernel on their own
+ * 'data_size' bytes. Returns -1 on error, 0 if the data size is too small
+ */
+int loaded_latency_test(memory_option_info_t *load, unsigned load_threads, unsigned_huge data_size) {
+	unsigned threads = load_threads + 1;
+	thread_arg_t *args = get_thread_array(threads);
+	if(args == NULL) {
+		_printf("Cannot allocate enough space for threads\n");
+		return -1;
+	}
+	volatile char *buffer = (volatile char *)memory_buffer_get(&loaded_buffer,
+			threads*data_size, threads, -1);
+	if(buffer == NULL) {
+		_printf("WARNING: couldn't init %Lu bytes for loaded latency benchmark\n", threads*data_size);
+		return -1;
+	}
+
+	unsigned_huge blocksize = 32, stride = 0;
+	range_reset(config.memory.blocksize);
+	range_next(config.memory.blocksize, &blocksize);
+	if(load->uses & MEMORY_USES_STRIDE) {
+		range_reset(config.memory.stride);
+		range_next(config.memory.stride, &stride);
+	}
+
+	loaded_control_t control = {0, 0};
+	int repetitions = config.repetitions.number;
+	double latency[repetitions];
+	loaded_thread_data_t data[threads];
+	unsigned i;
+	for(i=0; i<threads; i++) {
+		memory_function_arg_t arg;
+		memset(&arg, 0, sizeof(arg));
+		arg.data_size = data_size;
+		arg.buffer = buffer + i*data_size;
+		arg.page_size = loaded_buffer.page_size;
+		arg.threads = 1;
+		arg.chains = 1;
+		arg.steps = 1;
+		arg.cpu_node = -1;
+		arg.mem_node = -1;
+		if(i > 0) {
+			arg.blocksize = load->uses & MEMORY_USES_BLOCKSIZE ? blocksize : 0;
+			arg.stride = stride;
+			arg.uses_stride = (load->uses & MEMORY_USES_STRIDE) != 0;
+			arg.width = load->uses & MEMORY_USES_WIDTH ? LOADED_WIDTH : 0;
+			if(load->init_fn != NULL) load->init_fn(arg);
+		}
+		else {
+			chase_line_init(arg);
+		}
+		data[i].arg = arg;
+		data[i].access_fn = load->access_fn;
+		data[i].control = &control;
+		data[i].latency = latency;
+		data[i].repetitions = repetitions;
+		data[i].load_threads = load_threads;
+		args[i].reduce = false;
+		args[i].thread_count = threads;
+		args[i].loop_function = i == 0 ? &loaded_latency_loop : &loaded_load_loop;
+		args[i].data = &data[i];
+	}
+
+	threads_prepare(args, threads);
+	threads_start(args, threads);
+	threads_join(args, threads);
+
+	statistic_t stat_latency = middle_stat(latency, repetitions);
+	if(isnan(stat_latency.mean)) return 0;
+	double bandwidth = 0;
+	for(i=1; i<threads; i++) {
+		if(!data[i].datasize_enough) return 0;
+		bandwidth += data[i].transmitted / MB / data[i].time;
+	}
+
+	print_table_cell("%{load threads}5u, ", load_threads);
+	print_table_cell("%{repetitions}5d, ", repetitions);
+	print_table_cell("%{datasize}10Lu, ", data_size);
+	print_table_cell("%{latency ns}" PRECISSION "f, ", stat_latency.mean * 1e9);
+	print_table_cell("%{latency deviation ns}" PRECISSION "f, ", stat_latency.deviation * 1e9);
+	print_table_cell("%{cycles per access}" PRECISSION "f, ", stat_latency.mean * get_cpu_frequency(-1));
+	print_table_cell("%{aggregate bandwidth}" BIG_PRECISSION "f, ", bandwidth);
+	print_table_cell("%{bandwidth per load thread}" BIG_PRECISSION "f, ",
+			load_threads == 0 ? NAN : bandwidth / load_threads);
+	print_table_line();
+	return 1;
+}
+
+void start_loaded_latency_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("loaded latency benchmark\n");
+	_printf("latency of a pointer chase (one traversal per repetition) while threads-1 load threads run the load kernel\n");
+	_printf("bandwidth is Mebibyte / second = 1024*1024 byte / second\n");
+	_printf("buffer allocation: %s\n", memory_alloc_name(config.memory.alloc));
+	_printf("###############\n");
+
+	get_thread_array(config.threads->end);
+
+	if(option == NULL) option = "width-read,triad,contwrite-nt-sse2";
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	memory_option_info_t *load = NULL;
+
+	int set_load_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+		load = memory_find_option(options[num_option]);
+		if(load == NULL) {
+			_printf("WARNING: unknown option for loaded latency benchmark: %s\n", options[num_option]);
+			return NESTED_FOR_CONT;
+		}
+		print_table_set_additional_info("load kernel", load->name);
+		return 0;
+	}
+
+	int print_header_fn(unsigned level, iteration_var_t *vec) {
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge data_size; get_iteration_value("range", level, vec, &data_size);
+		unsigned_huge threads; get_iteration_value("thread", level, vec, &threads);
+		if(loaded_latency_test(load, threads - 1, data_size) < 0) return NESTED_FOR_BREAK;
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_load_fn;
+
+	for_loop_t range_loop = FOR_LOOP_T_INIT;
+	range_loop.var.name = "range";
+	range_loop.var.range = config.range;
+	range_loop.step_fn = &step_range;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+	thread_loop.outer_start_fn = &print_header_fn;
+
+	option_loop.next = &range_loop;
+	range_loop.next = &thread_loop;
+
+	nested_for_loop(&option_loop, fn);
+
+	memory_buffer_free(&loaded_buffer);
+}
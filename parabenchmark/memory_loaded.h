@@ -0,0 +1,30 @@
+/*
+ * memory_loaded.h
+ *
+ * Loaded latency: pointer chasing latency while other threads run a
+ * bandwidth kernel at full speed.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_LOADED_H
+#define __MEMORY_LOADED_H
+
+#include "definitions.h"
+
+void start_loaded_latency_benchmark(char *option);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * memory_prefetch.c
+ *
+ * Read kernels with software prefetches (prefetcht0, prefetcht2,
+ * prefetchnta) issued a configurable number of accesses ahead.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_prefetch.h"
+#include "memory_latency.h"
+#include "memory_benchmark.h"
+#include "print_functions.h"
+#include "timer.h"
+#include <stdint.h>
+#include <sched.h>
+
+#define LINES_PER_PAGE (PAGE_SIZE_4K / CACHE_LINE_SIZE)
+
+typedef enum {
+	PREFETCH_SEQUENTIAL,	// every cache line
+	PREFETCH_STRIDED,		// one cache line every 'stride' bytes
+	PREFETCH_PAGE			// pages in order, lines of a page in random order
+} prefetch_pattern_t;
+
+typedef enum {
+	PREFETCH_NONE,			// hardware prefetcher only (distance 0)
+	PREFETCH_T0,
+	PREFETCH_T2,
+	PREFETCH_NTA
+} prefetch_hint_t;
+
+/**
+ * order of the cache lines within a page (same for every page)
+ */
+unsigned char *prefetch_page_order() {
+	static unsigned char order[LINES_PER_PAGE];
+	static bool initialized = false;
+	if(!initialized) {
+		unsigned i;
+		unsigned_huge x = 0;
+		for(i=0; i<LINES_PER_PAGE; i++) order[i] = i;
+		for(i=LINES_PER_PAGE-1; i>0; i--) {
+			x = RANDOM_A*x + RANDOM_C;
+			unsigned j = (x >> 33) % (i+1);
+			unsigned char tmp = order[i]; order[i] = order[j]; order[j] = tmp;
+		}
+		initialized = true;
+	}
+	return order;
+}
+
+/**
+ * load one cache line every 'step' bytes and prefetch 'dist' bytes ahead
+ */
+#define PREFETCH_LINEAR_LOOP(prefetch) \
+	asm volatile ( \
+		"1:" \
+		prefetch \
+		"mov (%[p]), %%rax;" \
+		"add %[step], %[p];" \
+		"cmp %[end], %[p];" \
+		"jb 1b;" \
+		: [p] "+r" (p) \
+		: [step] "r" (step), [end] "r" (end), [dist] "r" (dist) \
+		: "rax", "cc", "memory" \
+	)
+
+void prefetch_linear(prefetch_hint_t hint, volatile char *p, volatile char *end,
+		unsigned_huge step, unsigned_huge dist) {
+	switch(hint) {
+	case PREFETCH_NONE: PREFETCH_LINEAR_LOOP(""); break;
+	case PREFETCH_T0: PREFETCH_LINEAR_LOOP("prefetcht0 (%[p],%[dist]);"); break;
+	case PREFETCH_T2: PREFETCH_LINEAR_LOOP("prefetcht2 (%[p],%[dist]);"); break;
+	case PREFETCH_NTA: PREFETCH_LINEAR_LOOP("prefetchnta (%[p],%[dist]);"); break;
+	}
+}
+
+/**
+ * offset of the n-th access of the page pattern:
+ * (n / LINES_PER_PAGE) * PAGE_SIZE_4K + order[n % LINES_PER_PAGE] * CACHE_LINE_SIZE
+ */
+#define PAGE_OFFSET(index, dest) \
+	"mov " index ", " dest ";" \
+	"shr $6, " dest ";" \
+	"shl $12, " dest ";" \
+	"mov " index ", %%rcx;" \
+	"and $63, %%rcx;" \
+	"movzbq (%[order],%%rcx), %%rcx;" \
+	"shl $6, %%rcx;" \
+	"add %%rcx, " dest ";"
+
+#define PAGE_PREFETCH(instr) \
+	"lea (%[n],%[dist]), %%rdx;" \
+	PAGE_OFFSET("%%rdx", "%%rax") \
+	instr " (%[base],%%rax);"
+
+#define PREFETCH_PAGE_LOOP(prefetch) \
+	asm volatile ( \
+		"1:" \
+		PAGE_OFFSET("%[n]", "%%rax") \
+		"mov (%[base],%%rax), %%rdx;" \
+		prefetch \
+		"inc %[n];" \
+		"cmp %[count], %[n];" \
+		"jb 1b;" \
+		: [n] "+r" (n) \
+		: [base] "r" (base), [order] "r" (order), [count] "r" (count), [dist] "r" (dist) \
+		: "rax", "rcx", "rdx", "cc", "memory" \
+	)
+
+void prefetch_page(prefetch_hint_t hint, volatile char *base, unsigned char *order,
+		unsigned_huge count, unsigned_huge dist) {
+	unsigned_huge n = 0;
+	switch(hint) {
+	case PREFETCH_NONE: PREFETCH_PAGE_LOOP(""); break;
+	case PREFETCH_T0: PREFETCH_PAGE_LOOP(PAGE_PREFETCH("prefetcht0")); break;
+	case PREFETCH_T2: PREFETCH_PAGE_LOOP(PAGE_PREFETCH("prefetcht2")); break;
+	case PREFETCH_NTA: PREFETCH_PAGE_LOOP(PAGE_PREFETCH("prefetchnta")); break;
+	}
+}
+
+/**
+ * Read one cache line per access, prefetching the line of the access
+ * 'arg.distance' accesses ahead. Prefetches beyond the buffer don't fault
+ */
+memory_result_t prefetch_test(memory_function_arg_t arg, prefetch_pattern_t pattern,
+		prefetch_hint_t hint) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	volatile char *base = (volatile char *)arg.buffer;
+	unsigned_huge step = CACHE_LINE_SIZE;
+	if(pattern == PREFETCH_STRIDED && arg.stride > CACHE_LINE_SIZE) {
+		step = (arg.stride + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+	}
+	unsigned_huge count = arg.data_size / step;
+	if(pattern == PREFETCH_PAGE) {
+		count = arg.data_size / PAGE_SIZE_4K * LINES_PER_PAGE;
+	}
+	if(count == 0) {
+		result.datasize_enough = false;
+		return result;
+	}
+	if(arg.distance == 0) hint = PREFETCH_NONE;
+	unsigned char *order = prefetch_page_order();
+
+	unsigned_huge step_count = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step_count-->0) {
+		if(pattern == PREFETCH_PAGE) {
+			prefetch_page(hint, base, order, count, arg.distance);
+		}
+		else {
+			prefetch_linear(hint, base, base + count*step, step, arg.distance*step);
+		}
+	}
+	result.time = tick_thread(MODE_END);
+	result.overhead = 0;
+
+	result.transmitted = arg.steps * ((double) count) * CACHE_LINE_SIZE;
+	result.datasize_enough = true;
+	result.blocksize = CACHE_LINE_SIZE;
+	result.stride = pattern == PREFETCH_STRIDED ? step : 0;
+	return result;
+}
+
+#define PREFETCH_TEST(pattern, pattern_enum) \
+	memory_result_t test_prefetch_ ## pattern ## _t0(memory_function_arg_t arg) { \
+		return prefetch_test(arg, pattern_enum, PREFETCH_T0); } \
+	memory_result_t test_prefetch_ ## pattern ## _t2(memory_function_arg_t arg) { \
+		return prefetch_test(arg, pattern_enum, PREFETCH_T2); } \
+	memory_result_t test_prefetch_ ## pattern ## _nta(memory_function_arg_t arg) { \
+		return prefetch_test(arg, pattern_enum, PREFETCH_NTA); }
+
+PREFETCH_TEST(seq, PREFETCH_SEQUENTIAL)
+PREFETCH_TEST(stride, PREFETCH_STRIDED)
+PREFETCH_TEST(page, PREFETCH_PAGE)
@@ -0,0 +1,38 @@
+/*
+ * memory_prefetch.h
+ *
+ * Read kernels with software prefetches (prefetcht0, prefetcht2,
+ * prefetchnta) issued a configurable number of accesses ahead.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_PREFETCH_H
+#define __MEMORY_PREFETCH_H
+
+#include "definitions.h"
+#include "memory_benchmark.h"
+
+#define PREFETCH_TEST_HEADER(pattern) \
+	memory_result_t test_prefetch_ ## pattern ## _t0(memory_function_arg_t arg); \
+	memory_result_t test_prefetch_ ## pattern ## _t2(memory_function_arg_t arg); \
+	memory_result_t test_prefetch_ ## pattern ## _nta(memory_function_arg_t arg);
+
+PREFETCH_TEST_HEADER(seq)
+PREFETCH_TEST_HEADER(stride)
+PREFETCH_TEST_HEADER(page)
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * memory_simd.c
+ *
+ * Memory kernels using SIMD instructions (STREAM copy, scale, add, triad
+ * and contiguous stores with and without non-temporal hints).
+ * The instruction set is selected at runtime with CPUID.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_simd.h"
+#include "memory_benchmark.h"
+#include "print_functions.h"
+#include "timer.h"
+#include <stdint.h>
+#include <sched.h>
+
+/**
+ * SIMD instruction set support (checked with CPUID)
+ */
+bool simd_supported(simd_level_t level) {
+	__builtin_cpu_init();
+	switch(level) {
+	case SIMD_AUTO: return true;
+	case SIMD_SCALAR:
+	case SIMD_SSE2: return __builtin_cpu_supports("sse2");
+	case SIMD_AVX2: return __builtin_cpu_supports("avx2");
+	case SIMD_AVX512: return __builtin_cpu_supports("avx512f");
+	}
+	return false;
+}
+
+simd_level_t simd_best_level() {
+	if(simd_supported(SIMD_AVX512)) return SIMD_AVX512;
+	if(simd_supported(SIMD_AVX2)) return SIMD_AVX2;
+	if(simd_supported(SIMD_SSE2)) return SIMD_SSE2;
+	return SIMD_SCALAR;
+}
+
+const char *simd_level_name(simd_level_t level) {
+	switch(level) {
+	case SIMD_AUTO: return "auto";
+	case SIMD_SCALAR: return "scalar";
+	case SIMD_SSE2: return "sse2";
+	case SIMD_AVX2: return "avx2";
+	case SIMD_AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+/**
+ * check level and resolve SIMD_AUTO. Print a warning only once per level
+ */
+bool simd_check_level(simd_level_t *level) {
+	static bool warned[SIMD_AVX512+1];
+	static bool printed_auto = false;
+	if(*level == SIMD_AUTO) {
+		*level = simd_best_level();
+		if(!printed_auto) {
+			_printf("auto selected simd instruction set: %s\n", simd_level_name(*level));
+			printed_auto = true;
+		}
+	}
+	if(!simd_supported(*level)) {
+		if(!warned[*level]) {
+			_printf("WARNING: cpu doesn't support %s instructions\n", simd_level_name(*level));
+			warned[*level] = true;
+		}
+		return false;
+	}
+	return true;
+}
+
+/**
+ * STREAM operations, see http://www.cs.virginia.edu/stream/
+ */
+typedef enum {
+	STREAM_COPY,	// c = a
+	STREAM_SCALE,	// b = scalar*c
+	STREAM_ADD,		// c = a + b
+	STREAM_TRIAD	// a = b + scalar*c
+} stream_op_t;
+
+#define STREAM_SCALAR 3.0
+#define STREAM_ALIGNMENT 64
+static double stream_scalar[8] __attribute__((aligned(STREAM_ALIGNMENT))) = {
+		STREAM_SCALAR, STREAM_SCALAR, STREAM_SCALAR, STREAM_SCALAR,
+		STREAM_SCALAR, STREAM_SCALAR, STREAM_SCALAR, STREAM_SCALAR};
+
+/**
+ * split the buffer into three aligned arrays a, b and c.
+ * Returns the size of one array in bytes
+ */
+unsigned_huge stream_arrays(memory_function_arg_t arg, double **a, double **b, double **c) {
+	uintptr_t start = (uintptr_t)arg.buffer;
+	uintptr_t aligned = (start + STREAM_ALIGNMENT - 1) & ~((uintptr_t)STREAM_ALIGNMENT - 1);
+	if(arg.data_size < aligned - start) return 0;
+	unsigned_huge bytes = (arg.data_size - (aligned - start)) / 3;
+	bytes &= ~((unsigned_huge)STREAM_ALIGNMENT - 1);
+	*a = (double *)aligned;
+	*b = (double *)(aligned + bytes);
+	*c = (double *)(aligned + 2*bytes);
+	return bytes;
+}
+
+/**
+ * initialize arrays like the STREAM benchmark does
+ */
+void stream_init(memory_function_arg_t arg) {
+	double *a, *b, *c;
+	unsigned_huge bytes = stream_arrays(arg, &a, &b, &c);
+	unsigned_huge i;
+	for(i=0; i<bytes/sizeof(double); i++) {
+		a[i] = 1.0;
+		b[i] = 2.0;
+		c[i] = 0.0;
+	}
+}
+
+/**
+ * register names and two/three operand instruction forms
+ */
+#define SIMD_REG(reg, n) "%%" reg #n
+#define SSE_OP(op, src, dst) op " " src ", " dst ";"
+#define AVX_OP(op, src, dst) op " " src ", " dst ", " dst ";"
+
+/**
+ * vector registers written by the SSE kernels, the AVX kernels clobber
+ * all of them (see AVX_CLOBBERS)
+ */
+#define SSE_CLOBBERS "xmm0", "xmm1", "xmm3"
+
+/**
+ * loop over the arrays, 'width' bytes per iteration
+ */
+#define STREAM_LOOP(init, body, tail, ...) \
+	asm volatile ( \
+		init \
+		"1:" \
+		body \
+		"add %[width], %[i];" \
+		"cmp %[bytes], %[i];" \
+		"jb 1b;" \
+		tail \
+		: [i] "+r" (i) \
+		: [a] "r" (a), [b] "r" (b), [c] "r" (c), [scalar] "r" (scalar), \
+		  [bytes] "r" (bytes), [width] "r" (width) \
+		: __VA_ARGS__, "cc", "memory" \
+	)
+
+/**
+ * generate one kernel function per instruction set
+ */
+#define STREAM_KERNEL(level, mov, mul, add, reg, simd_width, arith, tail, clobbers) \
+void stream_kernel_ ## level(stream_op_t op, double *a, double *b, double *c, \
+		double *scalar, unsigned_huge bytes) { \
+	unsigned_huge i = 0; \
+	unsigned_huge width = simd_width; \
+	switch(op) { \
+	case STREAM_COPY: \
+		STREAM_LOOP(, \
+			mov " (%[a],%[i]), " SIMD_REG(reg, 0) ";" \
+			mov " " SIMD_REG(reg, 0) ", (%[c],%[i]);", \
+			tail, clobbers); \
+		break; \
+	case STREAM_SCALE: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 3) ";", \
+			mov " (%[c],%[i]), " SIMD_REG(reg, 0) ";" \
+			arith(mul, SIMD_REG(reg, 3), SIMD_REG(reg, 0)) \
+			mov " " SIMD_REG(reg, 0) ", (%[b],%[i]);", \
+			tail, clobbers); \
+		break; \
+	case STREAM_ADD: \
+		STREAM_LOOP(, \
+			mov " (%[a],%[i]), " SIMD_REG(reg, 0) ";" \
+			mov " (%[b],%[i]), " SIMD_REG(reg, 1) ";" \
+			arith(add, SIMD_REG(reg, 1), SIMD_REG(reg, 0)) \
+			mov " " SIMD_REG(reg, 0) ", (%[c],%[i]);", \
+			tail, clobbers); \
+		break; \
+	case STREAM_TRIAD: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 3) ";", \
+			mov " (%[c],%[i]), " SIMD_REG(reg, 1) ";" \
+			arith(mul, SIMD_REG(reg, 3), SIMD_REG(reg, 1)) \
+			mov " (%[b],%[i]), " SIMD_REG(reg, 0) ";" \
+			arith(add, SIMD_REG(reg, 1), SIMD_REG(reg, 0)) \
+			mov " " SIMD_REG(reg, 0) ", (%[a],%[i]);", \
+			tail, clobbers); \
+		break; \
+	} \
+}
+
+STREAM_KERNEL(scalar, "movsd", "mulsd", "addsd", "xmm", 8, SSE_OP, "", SSE_CLOBBERS)
+STREAM_KERNEL(sse2, "movapd", "mulpd", "addpd", "xmm", 16, SSE_OP, "", SSE_CLOBBERS)
+STREAM_KERNEL(avx2, "vmovapd", "vmulpd", "vaddpd", "ymm", 32, AVX_OP, "vzeroupper;", AVX_CLOBBERS)
+STREAM_KERNEL(avx512, "vmovapd", "vmulpd", "vaddpd", "zmm", 64, AVX_OP, "vzeroupper;", AVX_CLOBBERS)
+
+typedef void (*stream_kernel_t)(stream_op_t, double *, double *, double *, double *, unsigned_huge);
+stream_kernel_t stream_kernels[] = {
+		[SIMD_SCALAR] = &stream_kernel_scalar,
+		[SIMD_SSE2] = &stream_kernel_sse2,
+		[SIMD_AVX2] = &stream_kernel_avx2,
+		[SIMD_AVX512] = &stream_kernel_avx512
+};
+
+/**
+ * Execute stream operation 'steps' times. The transmitted bytes are
+ * counted like in STREAM (no write allocate)
+ */
+memory_result_t stream_test(memory_function_arg_t arg, stream_op_t op, simd_level_t level) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	double *a, *b, *c;
+	unsigned_huge bytes = stream_arrays(arg, &a, &b, &c);
+	if(bytes == 0 || !simd_check_level(&level)) {
+		result.datasize_enough = false;
+		return result;
+	}
+	stream_kernel_t kernel = stream_kernels[level];
+
+	unsigned_huge step = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step-->0) {
+		kernel(op, a, b, c, stream_scalar, bytes);
+	}
+	result.time = tick_thread(MODE_END);
+	result.overhead = 0;
+
+	unsigned arrays = (op == STREAM_ADD || op == STREAM_TRIAD) ? 3 : 2;
+	result.transmitted = arg.steps * ((double) arrays) * bytes;
+	result.datasize_enough = true;
+	result.blocksize = 0;
+	result.stride = 0;
+	return result;
+}
+
+#define STREAM_TEST(op, op_enum) \
+	memory_result_t test_stream_ ## op(memory_function_arg_t arg) { \
+		return stream_test(arg, op_enum, SIMD_AUTO); } \
+	memory_result_t test_stream_ ## op ## _scalar(memory_function_arg_t arg) { \
+		return stream_test(arg, op_enum, SIMD_SCALAR); } \
+	memory_result_t test_stream_ ## op ## _sse2(memory_function_arg_t arg) { \
+		return stream_test(arg, op_enum, SIMD_SSE2); } \
+	memory_result_t test_stream_ ## op ## _avx2(memory_function_arg_t arg) { \
+		return stream_test(arg, op_enum, SIMD_AVX2); } \
+	memory_result_t test_stream_ ## op ## _avx512(memory_function_arg_t arg) { \
+		return stream_test(arg, op_enum, SIMD_AVX512); }
+
+STREAM_TEST(copy, STREAM_COPY)
+STREAM_TEST(scale, STREAM_SCALE)
+STREAM_TEST(add, STREAM_ADD)
+STREAM_TEST(triad, STREAM_TRIAD)
+
+/**
+ * contiguous stores, with normal and non-temporal (cache bypassing) moves
+ */
+typedef enum {
+	WRITE_STORE,		// a = value
+	WRITE_STORE_NT,
+	WRITE_READWRITE,	// a = a + value
+	WRITE_READWRITE_NT
+} write_op_t;
+
+static int32_t write_value[16] __attribute__((aligned(STREAM_ALIGNMENT))) = {
+		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+
+/**
+ * the whole buffer as one aligned array. Returns its size in bytes
+ */
+unsigned_huge write_array(memory_function_arg_t arg, double **a) {
+	uintptr_t start = (uintptr_t)arg.buffer;
+	uintptr_t aligned = (start + STREAM_ALIGNMENT - 1) & ~((uintptr_t)STREAM_ALIGNMENT - 1);
+	if(arg.data_size < aligned - start) return 0;
+	unsigned_huge bytes = arg.data_size - (aligned - start);
+	bytes &= ~((unsigned_huge)STREAM_ALIGNMENT - 1);
+	*a = (double *)aligned;
+	return bytes;
+}
+
+/**
+ * generate one kernel function per instruction set. The non-temporal
+ * stores are followed by a sfence, so that they are completed when the
+ * time is taken
+ */
+#define WRITE_KERNEL(level, mov, mov_nt, add, reg, simd_width, arith, tail, clobbers) \
+void write_kernel_ ## level(write_op_t op, double *a, unsigned_huge bytes) { \
+	unsigned_huge i = 0; \
+	unsigned_huge width = simd_width; \
+	double *b = a, *c = a; \
+	int32_t *scalar = write_value; \
+	switch(op) { \
+	case WRITE_STORE: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 1) ";", \
+			mov " " SIMD_REG(reg, 1) ", (%[a],%[i]);", \
+			tail, clobbers); \
+		break; \
+	case WRITE_STORE_NT: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 1) ";", \
+			mov_nt " " SIMD_REG(reg, 1) ", (%[a],%[i]);", \
+			"sfence;" tail, clobbers); \
+		break; \
+	case WRITE_READWRITE: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 1) ";", \
+			mov " (%[a],%[i]), " SIMD_REG(reg, 0) ";" \
+			arith(add, SIMD_REG(reg, 1), SIMD_REG(reg, 0)) \
+			mov " " SIMD_REG(reg, 0) ", (%[a],%[i]);", \
+			tail, clobbers); \
+		break; \
+	case WRITE_READWRITE_NT: \
+		STREAM_LOOP(mov " (%[scalar]), " SIMD_REG(reg, 1) ";", \
+			mov " (%[a],%[i]), " SIMD_REG(reg, 0) ";" \
+			arith(add, SIMD_REG(reg, 1), SIMD_REG(reg, 0)) \
+			mov_nt " " SIMD_REG(reg, 0) ", (%[a],%[i]);", \
+			"sfence;" tail, clobbers); \
+		break; \
+	} \
+}
+
+WRITE_KERNEL(sse2, "movdqa", "movntdq", "paddd", "xmm", 16, SSE_OP, "", SSE_CLOBBERS)
+WRITE_KERNEL(avx2, "vmovdqa", "vmovntdq", "vpaddd", "ymm", 32, AVX_OP, "vzeroupper;", AVX_CLOBBERS)
+WRITE_KERNEL(avx512, "vmovdqa64", "vmovntdq", "vpaddd", "zmm", 64, AVX_OP, "vzeroupper;", AVX_CLOBBERS)
+
+// scalar non-temporal stores (movnti) are in memory_benchmark.c
+typedef void (*write_kernel_t)(write_op_t, double *, unsigned_huge);
+write_kernel_t write_kernels[] = {
+		[SIMD_SCALAR] = NULL,
+		[SIMD_SSE2] = &write_kernel_sse2,
+		[SIMD_AVX2] = &write_kernel_avx2,
+		[SIMD_AVX512] = &write_kernel_avx512
+};
+
+/**
+ * Execute store operation 'steps' times. Every byte is counted once
+ */
+memory_result_t write_test(memory_function_arg_t arg, write_op_t op, simd_level_t level) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	double *a;
+	unsigned_huge bytes = write_array(arg, &a);
+	if(bytes == 0 || !simd_check_level(&level) || write_kernels[level] == NULL) {
+		result.datasize_enough = false;
+		return result;
+	}
+	write_kernel_t kernel = write_kernels[level];
+
+	unsigned_huge step = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step-->0) {
+		kernel(op, a, bytes);
+	}
+	result.time = tick_thread(MODE_END);
+	result.overhead = 0;
+
+	result.transmitted = arg.steps * ((double) bytes);
+	result.datasize_enough = true;
+	result.blocksize = 0;
+	result.stride = 0;
+	return result;
+}
+
+#define WRITE_TEST(level, level_enum) \
+	memory_result_t test_contwrite_ ## level(memory_function_arg_t arg) { \
+		return write_test(arg, WRITE_STORE, level_enum); } \
+	memory_result_t test_contwrite_nt_ ## level(memory_function_arg_t arg) { \
+		return write_test(arg, WRITE_STORE_NT, level_enum); } \
+	memory_result_t test_contreadwrite_ ## level(memory_function_arg_t arg) { \
+		return write_test(arg, WRITE_READWRITE, level_enum); } \
+	memory_result_t test_contreadwrite_nt_ ## level(memory_function_arg_t arg) { \
+		return write_test(arg, WRITE_READWRITE_NT, level_enum); }
+
+WRITE_TEST(sse2, SIMD_SSE2)
+WRITE_TEST(avx2, SIMD_AVX2)
+WRITE_TEST(avx512, SIMD_AVX512)
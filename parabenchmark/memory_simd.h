@@ -0,0 +1,76 @@
+/*
+ * memory_simd.h
+ *
+ * Memory kernels using SIMD instructions (STREAM copy, scale, add, triad
+ * and contiguous stores with and without non-temporal hints).
+ * The instruction set is selected at runtime with CPUID.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_SIMD_H
+#define __MEMORY_SIMD_H
+
+#include "definitions.h"
+#include "memory_benchmark.h"
+
+typedef enum {
+	SIMD_AUTO,
+	SIMD_SCALAR,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_AVX512
+} simd_level_t;
+
+bool simd_supported(simd_level_t level);
+simd_level_t simd_best_level();
+const char *simd_level_name(simd_level_t level);
+bool simd_check_level(simd_level_t *level);
+
+/**
+ * clobber list for inline assembly with vector registers. vzeroupper clears
+ * the upper halves of all 16 registers, so AVX code clobbers every one of them
+ */
+#define AVX_CLOBBERS "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7", \
+	"xmm8", "xmm9", "xmm10", "xmm11", "xmm12", "xmm13", "xmm14", "xmm15"
+
+unsigned_huge write_array(memory_function_arg_t arg, double **a);
+
+void stream_init(memory_function_arg_t arg);
+
+#define STREAM_TEST_HEADER(op) \
+	memory_result_t test_stream_ ## op(memory_function_arg_t arg); \
+	memory_result_t test_stream_ ## op ## _scalar(memory_function_arg_t arg); \
+	memory_result_t test_stream_ ## op ## _sse2(memory_function_arg_t arg); \
+	memory_result_t test_stream_ ## op ## _avx2(memory_function_arg_t arg); \
+	memory_result_t test_stream_ ## op ## _avx512(memory_function_arg_t arg);
+
+STREAM_TEST_HEADER(copy)
+STREAM_TEST_HEADER(scale)
+STREAM_TEST_HEADER(add)
+STREAM_TEST_HEADER(triad)
+
+#define WRITE_TEST_HEADER(level) \
+	memory_result_t test_contwrite_ ## level(memory_function_arg_t arg); \
+	memory_result_t test_contwrite_nt_ ## level(memory_function_arg_t arg); \
+	memory_result_t test_contreadwrite_ ## level(memory_function_arg_t arg); \
+	memory_result_t test_contreadwrite_nt_ ## level(memory_function_arg_t arg);
+
+WRITE_TEST_HEADER(sse2)
+WRITE_TEST_HEADER(avx2)
+WRITE_TEST_HEADER(avx512)
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * memory_width.c
+ *
+ * Contiguous read, write and read-modify-write kernels with a selectable
+ * access width from 1 to 64 bytes (scalar, SSE2, AVX2 and AVX-512).
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "memory_width.h"
+#include "memory_simd.h"
+#include "memory_benchmark.h"
+#include "print_functions.h"
+#include "timer.h"
+#include <stdint.h>
+#include <sched.h>
+
+/**
+ * accesses per loop iteration, so that the loop instructions don't
+ * dominate the narrow widths
+ */
+#define WIDTH_UNROLL 4
+
+typedef enum {
+	WIDTH_READ,
+	WIDTH_WRITE,
+	WIDTH_READWRITE		// read-modify-write of the same element
+} width_op_t;
+
+/**
+ * one access per width, 'off' is the byte offset relative to %[p]. The
+ * narrow loads zero extend, as a partial register write would depend on
+ * the previous load
+ */
+#define READ_1(off) "movzbl " off "(%[p]), %%eax;"
+#define WRITE_1(off) "movb %%al, " off "(%[p]);"
+#define READWRITE_1(off) "addb %%al, " off "(%[p]);"
+
+#define READ_2(off) "movzwl " off "(%[p]), %%eax;"
+#define WRITE_2(off) "movw %%ax, " off "(%[p]);"
+#define READWRITE_2(off) "addw %%ax, " off "(%[p]);"
+
+#define READ_4(off) "movl " off "(%[p]), %%eax;"
+#define WRITE_4(off) "movl %%eax, " off "(%[p]);"
+#define READWRITE_4(off) "addl %%eax, " off "(%[p]);"
+
+#define READ_8(off) "movq " off "(%[p]), %%rax;"
+#define WRITE_8(off) "movq %%rax, " off "(%[p]);"
+#define READWRITE_8(off) "addq %%rax, " off "(%[p]);"
+
+#define READ_16(off) "movdqa " off "(%[p]), %%xmm1;"
+#define WRITE_16(off) "movdqa %%xmm0, " off "(%[p]);"
+#define READWRITE_16(off) \
+	"movdqa " off "(%[p]), %%xmm1;" \
+	"paddd %%xmm0, %%xmm1;" \
+	"movdqa %%xmm1, " off "(%[p]);"
+
+#define READ_32(off) "vmovdqa " off "(%[p]), %%ymm1;"
+#define WRITE_32(off) "vmovdqa %%ymm0, " off "(%[p]);"
+#define READWRITE_32(off) \
+	"vpaddd " off "(%[p]), %%ymm0, %%ymm1;" \
+	"vmovdqa %%ymm1, " off "(%[p]);"
+
+#define READ_64(off) "vmovdqa64 " off "(%[p]), %%zmm1;"
+#define WRITE_64(off) "vmovdqa64 %%zmm0, " off "(%[p]);"
+#define READWRITE_64(off) \
+	"vpaddd " off "(%[p]), %%zmm0, %%zmm1;" \
+	"vmovdqa64 %%zmm1, " off "(%[p]);"
+
+/**
+ * WIDTH_UNROLL accesses at offset 0, w, 2w and 3w
+ */
+#define UNROLL(access, w) access("0") access(#w) access("2*" #w) access("3*" #w)
+
+#define WIDTH_LOOP(init, body, tail) \
+	asm volatile ( \
+		init \
+		"1:" \
+		body \
+		"add %[step], %[p];" \
+		"cmp %[end], %[p];" \
+		"jb 1b;" \
+		tail \
+		: [p] "+r" (p) \
+		: [end] "r" (end), [step] "r" (step) \
+		: "rax", AVX_CLOBBERS, "cc", "memory" \
+	)
+
+typedef void (*width_kernel_t)(width_op_t op, volatile char *p, volatile char *end);
+
+/**
+ * generate one kernel function per access width
+ */
+#define WIDTH_KERNEL(w, init, tail) \
+	void width_kernel_ ## w(width_op_t op, volatile char *p, volatile char *end) { \
+		unsigned_huge step = WIDTH_UNROLL * w; \
+		switch(op) { \
+		case WIDTH_READ: WIDTH_LOOP(init, UNROLL(READ_ ## w, w), tail); break; \
+		case WIDTH_WRITE: WIDTH_LOOP(init, UNROLL(WRITE_ ## w, w), tail); break; \
+		case WIDTH_READWRITE: WIDTH_LOOP(init, UNROLL(READWRITE_ ## w, w), tail); break; \
+		} \
+	}
+
+WIDTH_KERNEL(1, "xor %%eax, %%eax;", )
+WIDTH_KERNEL(2, "xor %%eax, %%eax;", )
+WIDTH_KERNEL(4, "xor %%eax, %%eax;", )
+WIDTH_KERNEL(8, "xor %%eax, %%eax;", )
+WIDTH_KERNEL(16, "pxor %%xmm0, %%xmm0;", )
+WIDTH_KERNEL(32, "vpxor %%ymm0, %%ymm0, %%ymm0;", "vzeroupper;")
+WIDTH_KERNEL(64, "vpxord %%zmm0, %%zmm0, %%zmm0;", "vzeroupper;")
+
+static struct {
+	unsigned width;
+	simd_level_t level;
+	width_kernel_t kernel;
+} width_kernels[] = {
+		{1, SIMD_SCALAR, &width_kernel_1},
+		{2, SIMD_SCALAR, &width_kernel_2},
+		{4, SIMD_SCALAR, &width_kernel_4},
+		{8, SIMD_SCALAR, &width_kernel_8},
+		{16, SIMD_SSE2, &width_kernel_16},
+		{32, SIMD_AVX2, &width_kernel_32},
+		{64, SIMD_AVX512, &width_kernel_64},
+		{0, SIMD_SCALAR, NULL}
+};
+
+/**
+ * kernel for an access width, NULL if the width or the instruction set
+ * isn't supported
+ */
+width_kernel_t width_kernel(unsigned width) {
+	int i;
+	for(i=0; width_kernels[i].kernel != NULL; i++) {
+		if(width_kernels[i].width != width) continue;
+		simd_level_t level = width_kernels[i].level;
+		return simd_check_level(&level) ? width_kernels[i].kernel : NULL;
+	}
+	static unsigned warned = -1;
+	if(warned != width) {
+		_printf("WARNING: access width %u not supported, use 1, 2, 4, 8, 16, 32 or 64\n", width);
+		warned = width;
+	}
+	return NULL;
+}
+
+/**
+ * Access the whole buffer 'steps' times with 'arg.width' bytes per
+ * instruction. Every byte is counted once
+ */
+memory_result_t width_test(memory_function_arg_t arg, width_op_t op) {
+	memory_result_t result = MEMORY_RESULT_T_INIT;
+	width_kernel_t kernel = width_kernel(arg.width);
+	if(kernel == NULL) {
+		result.datasize_enough = false;
+		return result;
+	}
+	double *a;
+	unsigned_huge bytes = write_array(arg, &a);
+	bytes -= bytes % (WIDTH_UNROLL * arg.width);
+	if(bytes == 0) {
+		result.datasize_enough = false;
+		return result;
+	}
+	volatile char *start = (volatile char *)a;
+
+	unsigned_huge step = arg.steps;
+	sched_yield();
+	tick_thread(MODE_START);
+	while(step-->0) {
+		kernel(op, start, start + bytes);
+	}
+	result.time = tick_thread(MODE_END);
+	result.overhead = 0;
+
+	result.transmitted = arg.steps * ((double) bytes);
+	result.datasize_enough = true;
+	result.blocksize = 0;
+	result.stride = 0;
+	return result;
+}
+
+memory_result_t test_width_read(memory_function_arg_t arg) {
+	return width_test(arg, WIDTH_READ);
+}
+
+memory_result_t test_width_write(memory_function_arg_t arg) {
+	return width_test(arg, WIDTH_WRITE);
+}
+
+memory_result_t test_width_readwrite(memory_function_arg_t arg) {
+	return width_test(arg, WIDTH_READWRITE);
+}
@@ -0,0 +1,33 @@
+/*
+ * memory_width.h
+ *
+ * Contiguous read, write and read-modify-write kernels with a selectable
+ * access width from 1 to 64 bytes (scalar, SSE2, AVX2 and AVX-512).
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __MEMORY_WIDTH_H
+#define __MEMORY_WIDTH_H
+
+#include "definitions.h"
+#include "memory_benchmark.h"
+
+memory_result_t test_width_read(memory_function_arg_t arg);
+memory_result_t test_width_write(memory_function_arg_t arg);
+memory_result_t test_width_readwrite(memory_function_arg_t arg);
+
+#endif
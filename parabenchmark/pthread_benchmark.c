@@ -10,6 +10,7 @@
 #include "nested_for.h"
 #include "system_info.h"
 #include "parse.h"
+#include "memory_benchmark.h"
 
 #include <unistd.h>
 #include <limits.h>
@@ -102,6 +103,57 @@ void* simple_float_arithmetic_loop(void *arg) {
 	return (void *)NULL;
 }
 
+/**
+ * maximum work units of one iteration of the imbalanced loops
+ */
+#define LOOP_MAX_COST 64
+
+/**
+ * add the iteration index 'units' times
+ */
+static inline unsigned long loop_cost(unsigned long result, unsigned_huge i, unsigned_huge units) {
+	asm volatile (
+		"1:"
+			"addq %[i], %[r];"
+			"decq %[u];"
+			"jnz 1b;"
+			: [r] "+r" (result), [u] "+r" (units)
+			: [i] "r" (i)
+			: "cc");
+	return result;
+}
+
+/**
+ * imbalanced loop, the cost of an iteration grows linearly from 1 to
+ * LOOP_MAX_COST work units over the whole loop
+ */
+void* linear_cost_loop(void *arg) {
+	thread_arg_t *args = (thread_arg_t*) arg;
+	unsigned long result = 0;
+	unsigned_huge i, n = args->iteration_count;
+	for(i=args->iteration_start; i<args->iteration_end; i++) {
+		result = loop_cost(result, i, 1 + (LOOP_MAX_COST - 1) * i / n);
+	}
+	args->result = result;
+	return (void *)NULL;
+}
+
+/**
+ * imbalanced loop, the cost of an iteration is a pseudo random number of
+ * 1 to LOOP_MAX_COST work units (the same for every run)
+ */
+void* random_cost_loop(void *arg) {
+	thread_arg_t *args = (thread_arg_t*) arg;
+	unsigned long result = 0;
+	unsigned_huge i;
+	for(i=args->iteration_start; i<args->iteration_end; i++) {
+		unsigned_huge random = (i * RANDOM_A + RANDOM_C) >> 33;
+		result = loop_cost(result, i, 1 + random % LOOP_MAX_COST);
+	}
+	args->result = result;
+	return (void *)NULL;
+}
+
 void *pthread_exit_wrapper(void *arg) {
 	pthread_exit(0);
 	return (void*)NULL;
@@ -241,37 +293,46 @@ void start_pthread_loop_benchmark(char *option) {
 	_printf("pthread loop benchmark\n");
 	_printf("###############\n");
 	void *(*loop_function_ptr)(void *) = &simple_integer_arithmetic_loop;
-	bool reduce = false;
+	reduce_strategy_t reduce = REDUCE_NONE;
+	schedule_t schedule = SCHEDULE_T_INIT;
 	print_table_set_additional_info("reduce option", "noreduce");
 
 	char *use_reduction = "reduce", *no_reduction = "noreduce";
 	char *loop_fn_int = "int", *loop_fn_float = "float";
+	char *loop_fn_linear = "linear", *loop_fn_random = "random";
 
 	// generate additional table columns
-	char *additional_info_header = "reduce option, loop function";
-	char *additional_info_reduce = "noreduce, ", *additional_info = NULL;
+	char *additional_info_header = "reduce option, loop function, schedule";
+	char *additional_info_reduce = "noreduce", *additional_info = NULL;
 
 	get_thread_array(config.threads->end);
 
 	if(option == NULL) option = "int";
 	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
-	char *token;
-	while((token = get_token(&get_token_pointers, option, NULL)) != NULL) {
+	char *token, *token_option;
+	while((token = get_token(&get_token_pointers, option, &token_option)) != NULL) {
 		// process pthread / loop option
 		if(strcmp(token, use_reduction) == 0) {
-			reduce = true;
-			additional_info_reduce = "reduce, ";
+			reduce = reduce_strategy_parse(token_option);
+			if(reduce == REDUCE_NONE) {
+				_printf("WARNING: unknown reduction strategy: %s\n", token_option);
+			}
+			additional_info_reduce = reduce_strategy_names[reduce];
 			continue;
 		}
 		if(strcmp(token, no_reduction) == 0) {
-			reduce = false;
-			additional_info_reduce = "noreduce, ";
+			reduce = REDUCE_NONE;
+			additional_info_reduce = reduce_strategy_names[reduce];
+			continue;
+		}
+		if(schedule_parse(token, token_option, &schedule)) {
 			continue;
 		}
 
 		free(additional_info);
 		additional_info = NULL;
 		strappend(&additional_info, additional_info_reduce);
+		strappend(&additional_info, ", ");
 
 		if(strcmp(token, loop_fn_int) == 0) {
 			loop_function_ptr = &simple_integer_arithmetic_loop;
@@ -282,10 +343,20 @@ void start_pthread_loop_benchmark(char *option) {
 			strappend(&additional_info, "float, ");
 
 		}
+		else if(strcmp(token, loop_fn_linear) == 0) {
+			loop_function_ptr = &linear_cost_loop;
+			strappend(&additional_info, "linear, ");
+		}
+		else if(strcmp(token, loop_fn_random) == 0) {
+			loop_function_ptr = &random_cost_loop;
+			strappend(&additional_info, "random, ");
+		}
 		else {
 			_printf("WARNING: unknown option for loop benchmark: %s\n", token);
 			continue;
 		}
+		schedule_append_name(&additional_info, schedule);
+		strappend(&additional_info, ", ");
 
 		print_table_set_additional_info(additional_info_header, additional_info);
 
@@ -305,7 +376,7 @@ void start_pthread_loop_benchmark(char *option) {
 			unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
 			unsigned_huge iterations; get_iteration_value("iteration", level, vec, &iterations);
 
-			pthread_loop_test(num_threads, iterations, reduce, loop_function_ptr);
+			pthread_loop_test(num_threads, iterations, reduce, schedule, loop_function_ptr);
 			return 0;
 		}
 
@@ -336,12 +407,15 @@ void start_pthread_loop_benchmark(char *option) {
 void pthread_loop_test(
 		unsigned num_threads,
 		unsigned_huge iterations,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *)) {
 
 	unsigned_huge i, loop_result;
 	statistic_t stat = STATISTIC_T_INIT;
+	statistic_t reduce_stat = STATISTIC_T_INIT;
 	int repetitions = 0;
+	double dispatch_overhead = NAN;
 
 	loop_result = 0;
 	if(num_threads > iterations || num_threads == 0) {
@@ -356,10 +430,21 @@ void pthread_loop_test(
 			_printf("Cannot allocate enough space for threads\n");
 			return;
 		}
+		loop_schedule_t *loop = NULL;
+		if(schedule.policy != SCHEDULE_STATIC) {
+			loop = loop_schedule_create(schedule, loop_function_ptr, 0, iterations, num_threads);
+			if(loop == NULL) {
+				_printf("WARNING: couldn't allocate loop schedule\n");
+				return;
+			}
+		}
 		for(i = 0; i<num_threads; i++) {
-			args[i].reduce = reduce;
+			args[i].reduce = reduce != REDUCE_NONE;
+			args[i].reduce_strategy = reduce;
 			args[i].thread_count = num_threads;
-			args[i].loop_function = loop_function_ptr;
+			args[i].iteration_count = iterations;
+			args[i].loop_function = loop == NULL ? loop_function_ptr : &loop_schedule_function;
+			args[i].data = loop;
 		}
 
 		unsigned_huge thread_iterations = iterations / num_threads;
@@ -375,27 +460,20 @@ void pthread_loop_test(
 				if(i == num_threads-1) {
 					args[i].iteration_end = iterations;
 				}
-				thread_init_wait(&args[i]);
-
-				pthread_mutex_lock(&(args[i].start_cond.mutex));
-				pthread_mutex_lock(&(args[i].end_cond.mutex));
-				pthread_cond_signal(&args[i].start_cond.condition);
-
 			}
+			if(loop != NULL) loop_schedule_reset(loop);
+			threads_prepare(args, num_threads);
 			double time;
 
 			tick(MODE_START);
-			for(i=0; i<num_threads; i++) {
-				pthread_mutex_unlock(&(args[i].start_cond.mutex));
-			}
-
-			for(i=0; i<num_threads; i++) {
-				pthread_cond_wait(&(args[i].end_cond.condition), &(args[i].end_cond.mutex));
-				pthread_mutex_unlock(&(args[i].end_cond.mutex));
-			}
+			threads_start(args, num_threads);
+			threads_join(args, num_threads);
 			time = tick(MODE_END);
 			if(r>=0) {
 				calculate_statistics_iterative(&stat, time);
+				if(reduce != REDUCE_NONE) {
+					calculate_statistics_iterative(&reduce_stat, threads_reduce_time(args, num_threads));
+				}
 			}
 			if(r>=config.repetitions.min) {
 				if(config.repetitions.time_guide_value > 0) {
@@ -409,7 +487,13 @@ void pthread_loop_test(
 
 			loop_result = args[0].result;
 		}
-
+		if(reduce != REDUCE_NONE && loop_function_ptr == &simple_integer_arithmetic_loop
+				&& loop_result != iterations * (iterations - 1) / 2) {
+			_printf("WARNING: %s reduction returned %Lu instead of %Lu\n", reduce_strategy_names[reduce],
+					loop_result, iterations * (iterations - 1) / 2);
+		}
+		loop_schedule_free(loop);
+		dispatch_overhead = threads_dispatch_overhead(num_threads);
 	}
 
 	print_table_cell("%{threads}5d, ", num_threads);
@@ -421,6 +505,8 @@ void pthread_loop_test(
 
 	print_table_cell("%{single}" PRECISSION "f, ", stat.mean/iterations);
 	print_table_cell("%{single deviation}" PRECISSION "f, ", stat.deviation/iterations);
+	print_table_cell("%{reduce time}" PRECISSION "f, ", reduce_stat.mean);
+	print_table_cell("%{dispatch overhead}" PRECISSION "f, ", dispatch_overhead);
 	print_table_line();
 }
 
@@ -436,6 +522,7 @@ unsigned pthread_loop_calculate_repetitions(
 	thread_arg_t arg = THREAD_ARG_T_INIT;
 	arg.iteration_start = 0;
 	arg.iteration_end = iterations;
+	arg.iteration_count = iterations;
 
 	tick(MODE_START);
 	loop_function_ptr(&arg);
@@ -3,6 +3,8 @@
 
 #include "definitions.h"
 #include "statistics.h"
+#include "pthread_functions.h"
+#include "loop_schedule.h"
 
 typedef struct pthread_create_benchmark_result_t_ {
 	unsigned num_threads;
@@ -17,12 +19,15 @@ STRUCT_ACCESS_ARG_HEADER(pthread_create_benchmark_result_t_, startup_time, stati
 
 void* simple_integer_arithmetic_loop(void *arg);
 void* simple_float_arithmetic_loop(void *arg);
+void* linear_cost_loop(void *arg);
+void* random_cost_loop(void *arg);
 
 void start_pthread_loop_benchmark();
 void pthread_loop_test(
 		unsigned num_threads,
 		unsigned_huge iterations,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *));
 unsigned pthread_loop_calculate_repetitions(
 				unsigned_huge iterations,
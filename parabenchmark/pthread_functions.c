@@ -3,12 +3,16 @@
 #include "pthread_functions.h"
 #include "config.h"
 #include "system_info.h"
+#include "timer.h"
+#include "statistics.h"
 
 #include <unistd.h>
 #define __USE_GNU
 #include <sched.h>
 #include <pthread.h>
 #include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 pthread_t *threads = NULL;
 thread_arg_t *thread_arguments = NULL;
@@ -99,10 +103,225 @@ inline void reduce_plus(thread_arg_t *args) {
 	}
 }
 
+char *reduce_strategy_names[] = {"noreduce", "reduce", "atomic", "slots", "spin-tree", "dissemination"};
+
+/**
+ * strategy of the test option 'reduce[strategy]', the condition variable
+ * tree without strategy. REDUCE_NONE, if the strategy is unknown
+ */
+reduce_strategy_t reduce_strategy_parse(char *option) {
+	if(option == NULL || strcmp(option, "condvar") == 0) return REDUCE_CONDVAR;
+	reduce_strategy_t strategy;
+	for(strategy=REDUCE_ATOMIC; strategy<REDUCE_STRATEGY_COUNT; strategy++) {
+		if(strcmp(option, reduce_strategy_names[strategy]) == 0) return strategy;
+	}
+	return REDUCE_NONE;
+}
+
+/**
+ * state shared by the reducing threads, reset by threads_start()
+ */
+struct {
+	volatile huge sum __attribute__((aligned(THREAD_CACHE_LINE)));
+	volatile unsigned arrived;
+	volatile int epoch __attribute__((aligned(THREAD_CACHE_LINE)));
+} reduce_shared;
+
+/**
+ * spinning threads yield the processor after this many polls, so that
+ * oversubscribed runs still make progress
+ */
+#define REDUCE_SPIN_YIELD 1024
+
+static inline void reduce_wait(volatile int *flag, int epoch) {
+	unsigned spins = 0;
+	while(*flag != epoch) {
+		if(++spins % REDUCE_SPIN_YIELD == 0) sched_yield();
+		else __asm__ __volatile__ ("pause" ::: "memory");
+	}
+}
+
+static inline void reduce_publish(thread_arg_t *arg, unsigned round, huge value, int epoch) {
+	arg->reduce_value[round] = value;
+	__sync_synchronize();
+	arg->reduce_flag[round] = epoch;
+}
+
+void reduce_atomic(thread_arg_t *arg) {
+	__sync_fetch_and_add(&reduce_shared.sum, arg->result);
+	__sync_fetch_and_add(&reduce_shared.arrived, 1);
+	if(arg->tid == 0) {
+		unsigned spins = 0;
+		while(reduce_shared.arrived != arg->thread_count) {
+			if(++spins % REDUCE_SPIN_YIELD == 0) sched_yield();
+			else __asm__ __volatile__ ("pause" ::: "memory");
+		}
+		arg->result = reduce_shared.sum;
+	}
+}
+
+void reduce_slots(thread_arg_t *arg) {
+	int epoch = reduce_shared.epoch;
+	if(arg->tid != 0) {
+		reduce_publish(arg, 0, arg->result, epoch);
+		return;
+	}
+	unsigned i;
+	for(i=1; i<arg->thread_count; i++) {
+		reduce_wait(&arg->allargs[i].reduce_flag[0], epoch);
+		arg->result += arg->allargs[i].reduce_value[0];
+	}
+}
+
+void reduce_spin_tree(thread_arg_t *arg) {
+	int epoch = reduce_shared.epoch;
+	unsigned stride;
+	for(stride=1; stride<arg->thread_count; stride*=2) {
+		if(arg->tid % (2*stride) != 0) {
+			reduce_publish(arg, 0, arg->result, epoch);
+			return;
+		}
+		unsigned partner = arg->tid + stride;
+		if(partner < arg->thread_count) {
+			reduce_wait(&arg->allargs[partner].reduce_flag[0], epoch);
+			arg->result += arg->allargs[partner].reduce_value[0];
+		}
+	}
+}
+
+/**
+ * Butterfly over the largest power of two of the threads. The remaining
+ * threads add their result to a partner before the first round and get
+ * the sum from it after the last round
+ */
+void reduce_dissemination(thread_arg_t *arg) {
+	int epoch = reduce_shared.epoch;
+	thread_arg_t *all = arg->allargs;
+	unsigned tid = arg->tid, n = arg->thread_count;
+	unsigned p2 = 1, round = 0, distance;
+	while(2*p2 <= n) p2 *= 2;
+
+	if(tid >= p2) {
+		reduce_publish(arg, 0, arg->result, epoch);
+		reduce_wait(&all[tid - p2].reduce_flag[REDUCE_MAX_ROUNDS-1], epoch);
+		arg->result = all[tid - p2].reduce_value[REDUCE_MAX_ROUNDS-1];
+		return;
+	}
+	if(tid + p2 < n) {
+		reduce_wait(&all[tid + p2].reduce_flag[0], epoch);
+		arg->result += all[tid + p2].reduce_value[0];
+	}
+	for(distance=1; distance<p2; distance*=2) {
+		unsigned partner = tid ^ distance;
+		round++;
+		reduce_publish(arg, round, arg->result, epoch);
+		reduce_wait(&all[partner].reduce_flag[round], epoch);
+		arg->result += all[partner].reduce_value[round];
+	}
+	if(tid + p2 < n) {
+		reduce_publish(arg, REDUCE_MAX_ROUNDS-1, arg->result, epoch);
+	}
+}
+
+static inline double reduce_now() {
+	timespec_t now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+/**
+ * combine the partial results in args[0].result, and record the time
+ * stamps for threads_reduce_time()
+ */
+void reduce_result(thread_arg_t *arg) {
+	arg->loop_end = reduce_now();
+	switch(arg->reduce_strategy) {
+	case REDUCE_ATOMIC: reduce_atomic(arg); break;
+	case REDUCE_SLOTS: reduce_slots(arg); break;
+	case REDUCE_SPIN_TREE: reduce_spin_tree(arg); break;
+	case REDUCE_DISSEMINATION: reduce_dissemination(arg); break;
+	default: reduce_plus(arg); break;
+	}
+	arg->reduce_end = reduce_now();
+}
+
+/**
+ * time of the last reduction, from the end of the slowest loop function
+ * until the last thread has finished reducing
+ */
+double threads_reduce_time(thread_arg_t *args, unsigned num_threads) {
+	double loop_end = 0, reduce_end = 0;
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		loop_end = args[i].loop_end > loop_end ? args[i].loop_end : loop_end;
+		reduce_end = args[i].reduce_end > reduce_end ? args[i].reduce_end : reduce_end;
+	}
+	return reduce_end - loop_end;
+}
+
+
+/**
+ * Wait while '*addr' equals 'value': spin for config.dispatch_spin_time
+ * seconds, then sleep on a futex. '*sleeping' tells the other side, that
+ * it has to wake the waiting thread
+ */
+void dispatch_wait(volatile int *addr, int value, volatile int *sleeping) {
+	unsigned spins = 0;
+	double start;
+	tick2(MODE_START, &start);
+	while(*addr == value) {
+		__asm__ __volatile__ ("pause" ::: "memory");
+		if(++spins % 256 == 0 && tick2(MODE_END, &start) > config.dispatch_spin_time) break;
+	}
+	while(*addr == value) {
+		*sleeping = 1;
+		__sync_synchronize();
+		if(*addr == value) {
+			syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+		}
+		*sleeping = 0;
+	}
+}
+
+void dispatch_set(volatile int *addr, int value, volatile int *sleeping) {
+	*addr = value;
+	__sync_synchronize();
+	if(*sleeping) {
+		syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+}
+
+/**
+ * worker loop of the spin dispatch: wait for the next generation, run the
+ * loop function and publish the finished generation
+ */
+void *thread_function_spin(thread_arg_t *arg) {
+	int generation = arg->generation;
+	arg->status = THREAD_INITIALIZED;
+	while(true) {
+		dispatch_wait(&arg->generation, generation, &arg->sleeping);
+		generation = arg->generation;
+		if(arg->status == THREAD_CANCEL) break;
+		arg->status = THREAD_RUNNING;
+
+		arg->loop_function(arg);
+		if(arg->reduce) {
+			reduce_result(arg);
+		}
+
+		arg->status = THREAD_INITIALIZED;
+		dispatch_set(&arg->finished, generation, &arg->joining);
+	}
+	arg->status = THREAD_FINISHED;
+	return (void *)NULL;
+}
 
 void* thread_function(void *arg_ptr) {
 	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
 	thread_affinity(arg->tid);
+	if(config.thread_dispatch == DISPATCH_SPIN) {
+		return thread_function_spin(arg);
+	}
 
 	pthread_mutex_lock(&arg->start_cond.mutex);
 	while(true) {
@@ -113,7 +332,7 @@ void* thread_function(void *arg_ptr) {
 
 		arg->loop_function(arg_ptr);
 		if(arg->reduce) {
-			reduce_plus(arg);
+			reduce_result(arg);
 		}
 
 		int i = 0;
@@ -126,6 +345,95 @@ void* thread_function(void *arg_ptr) {
 	return (void *)NULL;
 }
 
+/**
+ * wait until the threads are ready and signal them to start.
+ * The threads are blocked until threads_start() is called
+ */
+void threads_prepare(thread_arg_t *args, unsigned num_threads) {
+	int i;
+	if(config.thread_dispatch == DISPATCH_SPIN) {
+		for(i=0; i<num_threads; i++) {
+			while(args[i].status != THREAD_INITIALIZED) sched_yield();
+		}
+		return;
+	}
+	for(i=0; i<num_threads; i++) {
+		thread_init_wait(&args[i]);
+
+		pthread_mutex_lock(&(args[i].start_cond.mutex));
+		pthread_mutex_lock(&(args[i].end_cond.mutex));
+		pthread_cond_signal(&args[i].start_cond.condition);
+	}
+}
+
+/**
+ * let the threads prepared by threads_prepare() run their loop function
+ */
+void threads_start(thread_arg_t *args, unsigned num_threads) {
+	int i;
+	reduce_shared.sum = 0;
+	reduce_shared.arrived = 0;
+	reduce_shared.epoch++;
+	if(config.thread_dispatch == DISPATCH_SPIN) {
+		for(i=0; i<num_threads; i++) {
+			dispatch_set(&args[i].generation, args[i].generation + 1, &args[i].sleeping);
+		}
+		return;
+	}
+	for(i=0; i<num_threads; i++) {
+		pthread_mutex_unlock(&(args[i].start_cond.mutex));
+	}
+}
+
+/**
+ * wait until all threads finished their loop function
+ */
+void threads_join(thread_arg_t *args, unsigned num_threads) {
+	int i;
+	if(config.thread_dispatch == DISPATCH_SPIN) {
+		for(i=0; i<num_threads; i++) {
+			dispatch_wait(&args[i].finished, args[i].generation - 1, &args[i].joining);
+		}
+		return;
+	}
+	for(i=0; i<num_threads; i++) {
+		pthread_cond_wait(&(args[i].end_cond.condition), &(args[i].end_cond.mutex));
+		pthread_mutex_unlock(&(args[i].end_cond.mutex));
+	}
+}
+
+void *dispatch_empty_loop(void *arg) {
+	return (void *)NULL;
+}
+
+#define DISPATCH_SAMPLES 32
+
+/**
+ * median time of an empty fork/join (threads_start() and threads_join(),
+ * as timed by the benchmarks) with the first 'num_threads' pool threads.
+ * The loop functions of the threads are overwritten
+ */
+double threads_dispatch_overhead(unsigned num_threads) {
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL || num_threads == 0) return NAN;
+	int i, r;
+	for(i=0; i<num_threads; i++) {
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &dispatch_empty_loop;
+	}
+	double time[DISPATCH_SAMPLES];
+	for(r=-1; r<DISPATCH_SAMPLES; r++) {
+		threads_prepare(args, num_threads);
+		tick(MODE_START);
+		threads_start(args, num_threads);
+		threads_join(args, num_threads);
+		double t = tick(MODE_END);
+		if(r >= 0) time[r] = t;
+	}
+	return median(time, DISPATCH_SAMPLES);
+}
+
 thread_arg_t *get_thread_array(unsigned num) {
 	if(num <= threads_size) {
 		return thread_arguments;
@@ -137,14 +445,16 @@ thread_arg_t *get_thread_array(unsigned num) {
 	while(range_next(config.threads, &act)) {
 		if(max < act) max = act;
 	}
+	if(max < num) max = num;
 	if(threads == NULL)
 		threads = malloc(max*sizeof(pthread_t));
 	if(threads == NULL) {
 		_printf("WARNING: couldn't allocate thread array\n");
 		return NULL;
 	}
-	if(thread_arguments == NULL)
-	thread_arguments = malloc(sizeof(thread_arg_t)*(max));
+	if(thread_arguments == NULL
+			&& posix_memalign((void **)&thread_arguments, THREAD_CACHE_LINE, sizeof(thread_arg_t)*(max)) != 0)
+		thread_arguments = NULL;
 	if(thread_arguments == NULL) {
 		_printf("WARNING: couldn't allocate thread arguments array\n");
 		return NULL;
@@ -182,7 +492,13 @@ void finish_threads() {
 	int i;
 	for(i=0; i<threads_size; i++) {
 		thread_arguments[i].status = THREAD_CANCEL;
-		thread_cond_signal(&thread_arguments[i].start_cond, NULL);
+		if(config.thread_dispatch == DISPATCH_SPIN) {
+			dispatch_set(&thread_arguments[i].generation, thread_arguments[i].generation + 1,
+					&thread_arguments[i].sleeping);
+		}
+		else {
+			thread_cond_signal(&thread_arguments[i].start_cond, NULL);
+		}
 	}
 	for(i=0; i<threads_size; i++) {
 		while(thread_arguments[i].status != THREAD_FINISHED)
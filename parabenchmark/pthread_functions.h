@@ -39,6 +39,25 @@ typedef struct {
 
 #define THREAD_COND_T_INIT {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, -1}
 
+#define THREAD_CACHE_LINE 64
+
+/**
+ * how the partial results are combined, if 'reduce' is set
+ */
+typedef enum {
+	REDUCE_NONE,
+	REDUCE_CONDVAR,			// binary tree of condition variable waits
+	REDUCE_ATOMIC,			// one atomic accumulator
+	REDUCE_SLOTS,			// padded per-thread slots, summed by thread 0
+	REDUCE_SPIN_TREE,		// binary tree of spin flags
+	REDUCE_DISSEMINATION,	// butterfly, every thread gets the sum
+	REDUCE_STRATEGY_COUNT
+} reduce_strategy_t;
+
+#define REDUCE_MAX_ROUNDS 32
+
+extern char *reduce_strategy_names[];
+
 struct test_function_arg_t_;
 typedef struct test_function_arg_t_ thread_arg_t;
 struct test_function_arg_t_ {
@@ -50,6 +69,7 @@ struct test_function_arg_t_ {
 	void *(*loop_function)(void *);
 	unsigned_huge iteration_start;
 	unsigned_huge iteration_end;
+	unsigned_huge iteration_count;	// iterations of the whole loop
 
 	thread_cond_t init_cond;
 	thread_cond_t start_cond;
@@ -61,19 +81,44 @@ struct test_function_arg_t_ {
 	bool reduce;
 	huge result;
 	double time;
+
+	void *data;
+
+	// spin dispatch, written by the main thread
+	volatile int generation __attribute__((aligned(THREAD_CACHE_LINE)));	// incremented to start the thread
+	volatile int joining;	// main thread sleeps on 'finished'
+	// written by the thread
+	volatile int finished __attribute__((aligned(THREAD_CACHE_LINE)));	// generation of the last finished run
+	volatile int sleeping;	// thread sleeps on 'generation'
+
+	// reduction
+	reduce_strategy_t reduce_strategy;
+	double loop_end;	// monotonic time stamps of the last run
+	double reduce_end;
+	// partial results of the spin strategies, read by the partner of the round
+	volatile huge reduce_value[REDUCE_MAX_ROUNDS] __attribute__((aligned(THREAD_CACHE_LINE)));
+	volatile int reduce_flag[REDUCE_MAX_ROUNDS];	// epoch of the reduction
 };
 
 #define THREAD_ARG_T_INIT { \
 		NULL, 0, 0, NULL, \
-		NULL, 0, 0, \
+		NULL, 0, 0, 0, \
 		THREAD_COND_T_INIT, THREAD_COND_T_INIT, THREAD_COND_T_INIT, THREAD_CREATED, \
-		THREAD_COND_T_INIT, false, false, 0, 0.0}
+		THREAD_COND_T_INIT, false, false, 0, 0.0, \
+		NULL}
 
 thread_arg_t *get_thread_array(unsigned num);
 void thread_init_wait(thread_arg_t *arg);
 void *thread_function(void *arg);
 
+void threads_prepare(thread_arg_t *args, unsigned num_threads);
+void threads_start(thread_arg_t *args, unsigned num_threads);
+void threads_join(thread_arg_t *args, unsigned num_threads);
+double threads_dispatch_overhead(unsigned num_threads);
+
 void thread_affinity(int threadid);
 void reduce_plus(thread_arg_t *args);
+reduce_strategy_t reduce_strategy_parse(char *option);
+double threads_reduce_time(thread_arg_t *args, unsigned num_threads);
 
 #endif
@@ -52,25 +52,29 @@ extern int world_rank;
  */
 typedef struct {
 	unsigned_huge iterations;
+	void *(*loop_function_ptr)(void *);
 	double *measurement_time;
 	unsigned_huge size;
 } serial_time_cache_t;
 
-serial_time_cache_t SERIAL_TIME_CACHE_T_INIT = {0, NULL, 0};
+serial_time_cache_t SERIAL_TIME_CACHE_T_INIT = {0, NULL, NULL, 0};
 
 /**
- * Get cache line for data size 'iterations' (warning: name mismatch)
+ * Get cache line for data size 'iterations' of a loop function (warning:
+ * name mismatch). The serial run doesn't depend on the schedule
  */
 serial_time_cache_t *get_cache_line(
 		unsigned *size_ptr,
 		serial_time_cache_t **cache_ptr,
-		unsigned_huge iterations)
+		unsigned_huge iterations,
+		void *(*loop_function_ptr)(void *))
 {
 	unsigned size = *size_ptr;
 	serial_time_cache_t *cache = *cache_ptr;
 	int i;
 	for(i=0; i<size; i++) {
-		if(cache[i].iterations == iterations)
+		if(cache[i].iterations == iterations
+				&& cache[i].loop_function_ptr == loop_function_ptr)
 			return &cache[i];
 	}
 	unsigned newsize = size + 1;
@@ -80,6 +84,7 @@ serial_time_cache_t *get_cache_line(
 	cache = (serial_time_cache_t*)new_ptr;
 	cache[size] = SERIAL_TIME_CACHE_T_INIT;
 	cache[size].iterations = iterations;
+	cache[size].loop_function_ptr = loop_function_ptr;
 
 	*cache_ptr = cache;
 	*size_ptr = newsize;
@@ -94,7 +99,8 @@ void speedup_benchmark(
 		unsigned_huge num_processes,
 		unsigned_huge num_threads,
 		unsigned_huge iterations,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *),
 		serial_time_cache_t *cacheline);
 
@@ -106,37 +112,46 @@ void start_speedup_benchmark(char *option) {
 	_printf("speedup benchmark\n");
 	_printf("###############\n");
 	void *(*loop_function_ptr)(void *) = &simple_integer_arithmetic_loop;
-	bool reduce = false;
+	reduce_strategy_t reduce = REDUCE_NONE;
+	schedule_t schedule = SCHEDULE_T_INIT;
 	print_table_set_additional_info("reduce option", "noreduce");
 
 	char *use_reduction = "reduce", *no_reduction = "noreduce";
 	char *loop_fn_int = "int", *loop_fn_float = "float";
+	char *loop_fn_linear = "linear", *loop_fn_random = "random";
 
 	// generate additional table columns
-	char *additional_info_header = "reduce option, loop function";
-	char *additional_info_reduce = "noreduce, ", *additional_info = NULL;
+	char *additional_info_header = "reduce option, loop function, schedule";
+	char *additional_info_reduce = "noreduce", *additional_info = NULL;
 
 	get_thread_array(config.threads->end);
 
 	if(option == NULL) option = "int";
 	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
-	char *token;
-	while((token = get_token(&get_token_pointers, option, NULL)) != NULL) {
+	char *token, *token_option;
+	while((token = get_token(&get_token_pointers, option, &token_option)) != NULL) {
 		// process pthread / loop option
 		if(strcmp(token, use_reduction) == 0) {
-			reduce = true;
-			additional_info_reduce = "reduce, ";
+			reduce = reduce_strategy_parse(token_option);
+			if(reduce == REDUCE_NONE) {
+				_printf("WARNING: unknown reduction strategy: %s\n", token_option);
+			}
+			additional_info_reduce = reduce_strategy_names[reduce];
 			continue;
 		}
 		if(strcmp(token, no_reduction) == 0) {
-			reduce = false;
-			additional_info_reduce = "noreduce, ";
+			reduce = REDUCE_NONE;
+			additional_info_reduce = reduce_strategy_names[reduce];
+			continue;
+		}
+		if(schedule_parse(token, token_option, &schedule)) {
 			continue;
 		}
 
 		free(additional_info);
 		additional_info = NULL;
 		strappend(&additional_info, additional_info_reduce);
+		strappend(&additional_info, ", ");
 
 		if(strcmp(token, loop_fn_int) == 0) {
 			loop_function_ptr = &simple_integer_arithmetic_loop;
@@ -147,10 +162,20 @@ void start_speedup_benchmark(char *option) {
 			strappend(&additional_info, "float, ");
 
 		}
+		else if(strcmp(token, loop_fn_linear) == 0) {
+			loop_function_ptr = &linear_cost_loop;
+			strappend(&additional_info, "linear, ");
+		}
+		else if(strcmp(token, loop_fn_random) == 0) {
+			loop_function_ptr = &random_cost_loop;
+			strappend(&additional_info, "random, ");
+		}
 		else {
 			_printf("WARNING: unknown option for loop benchmark: %s\n", token);
 			continue;
 		}
+		schedule_append_name(&additional_info, schedule);
+		strappend(&additional_info, ", ");
 
 		print_table_set_additional_info(additional_info_header, additional_info);
 
@@ -195,9 +220,9 @@ void start_speedup_benchmark(char *option) {
 			unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
 			unsigned_huge iterations; get_iteration_value("iteration", level, vec, &iterations);
 
-			serial_time_cache_t *cacheline = get_cache_line(&cache_size, &cache, iterations);
+			serial_time_cache_t *cacheline = get_cache_line(&cache_size, &cache, iterations, loop_function_ptr);
 			speedup_benchmark(num_processes, num_threads, iterations,
-					reduce, loop_function_ptr, cacheline);
+					reduce, schedule, loop_function_ptr, cacheline);
 			return 0;
 		}
 
@@ -235,7 +260,8 @@ void speedup_benchmark(
 		unsigned_huge num_processes,
 		unsigned_huge num_threads,
 		unsigned_huge iterations,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *),
 		serial_time_cache_t *cacheline) {
 
@@ -243,7 +269,9 @@ void speedup_benchmark(
 	statistic_t thread_time_total_stat = STATISTIC_T_INIT;
 	statistic_t serial_time_stat = STATISTIC_T_INIT;
 	statistic_t speedup_stat = STATISTIC_T_INIT;
+	statistic_t reduce_stat = STATISTIC_T_INIT;
 	int repetitions = 0;
+	double dispatch_overhead = 0;
 
 	if(num_processes * num_threads > iterations ||
 			num_threads == 0 ||
@@ -260,10 +288,13 @@ void speedup_benchmark(
 			return;
 		}
 		for(i = 0; i<num_threads; i++) {
-			args[i].reduce = reduce;
+			args[i].reduce = reduce != REDUCE_NONE;
+			args[i].reduce_strategy = reduce;
 			args[i].thread_count = num_threads;
+			args[i].iteration_count = iterations;
 			args[i].loop_function = loop_function_ptr;
 		}
+		loop_schedule_t *loop = NULL;
 
 		unsigned_huge thread_iterations;
 		unsigned_huge rest;
@@ -284,6 +315,7 @@ void speedup_benchmark(
 		thread_arg_t arg = THREAD_ARG_T_INIT;
 		arg.iteration_start = 0;
 		arg.iteration_end = iterations;
+		arg.iteration_count = iterations;
 		double *serial_time = NULL; bool run_serial = true;
 
 		if(cacheline != NULL) {
@@ -345,15 +377,26 @@ void speedup_benchmark(
 						args[i].iteration_end = iterations;
 					}
 				#endif
-
-				thread_init_wait(&args[i]);
-
-				if(num_threads > 1) {
-					pthread_mutex_lock(&(args[i].start_cond.mutex));
-					pthread_mutex_lock(&(args[i].end_cond.mutex));
-					pthread_cond_signal(&args[i].start_cond.condition);
+			}
+			if(num_threads > 1 && schedule.policy != SCHEDULE_STATIC) {
+				// schedule the iterations of this process
+				if(loop == NULL) {
+					loop = loop_schedule_create(schedule, loop_function_ptr,
+							args[0].iteration_start, args[num_threads-1].iteration_end, num_threads);
+				}
+				if(loop == NULL) {
+					_printf("WARNING: couldn't allocate loop schedule\n");
+					break;
+				}
+				loop_schedule_reset(loop);
+				for(i = 0; i<num_threads; i++) {
+					args[i].loop_function = &loop_schedule_function;
+					args[i].data = loop;
 				}
 			}
+			if(num_threads > 1) {
+				threads_prepare(args, num_threads);
+			}
 			double thread_time_total;
 			if(num_threads == 1) {
 #ifdef COMPILE_WITH_MPI
@@ -379,14 +422,8 @@ void speedup_benchmark(
 				tick(MODE_START);
 #endif
 
-				for(i=0; i<num_threads; i++) {
-					pthread_mutex_unlock(&(args[i].start_cond.mutex));
-				}
-
-				for(i = 0; i<num_threads; i++) {
-					pthread_cond_wait(&(args[i].end_cond.condition), &(args[i].end_cond.mutex));
-					pthread_mutex_unlock(&(args[i].end_cond.mutex));
-				}
+				threads_start(args, num_threads);
+				threads_join(args, num_threads);
 #ifdef COMPILE_WITH_MPI
 				if(num_processes == 1) {
 					thread_time_total = tick(MODE_END);
@@ -403,6 +440,9 @@ void speedup_benchmark(
 				double speedup = serial_time[r] / thread_time_total;
 				calculate_statistics_iterative(&thread_time_total_stat, thread_time_total);
 				calculate_statistics_iterative(&speedup_stat, speedup);
+				if(num_threads > 1 && reduce != REDUCE_NONE) {
+					calculate_statistics_iterative(&reduce_stat, threads_reduce_time(args, num_threads));
+				}
 			}
 			if(r>=config.repetitions.min) {
 				double time = thread_time_total_stat.mean * (r + 1);
@@ -413,6 +453,7 @@ void speedup_benchmark(
 				}
 			}
 		}
+		loop_schedule_free(loop);
 		#ifdef COMPILE_WITH_MPI
 		MPI_Comm_free(&comm);
 		}
@@ -440,6 +481,9 @@ void speedup_benchmark(
 
 		print_table_cell("%{speedup}" PRECISSION "f,", speedup_stat.mean);
 		print_table_cell("%{speedup deviation}" PRECISSION "f, ", speedup_stat.deviation);
+		print_table_cell("%{reduce time}" PRECISSION "f, ", reduce_stat.mean);
+		if(num_threads > 1) dispatch_overhead = threads_dispatch_overhead(num_threads);
+		print_table_cell("%{dispatch overhead}" PRECISSION "f, ", dispatch_overhead);
 		print_table_line();
 	}
 }
@@ -459,6 +503,7 @@ unsigned speedup_calculate_repetitions(
 	thread_arg_t arg = THREAD_ARG_T_INIT;
 	arg.iteration_start = 0;
 	arg.iteration_end = iterations;
+	arg.iteration_count = iterations;
 
 	tick(MODE_START);
 	loop_function_ptr(&arg);
@@ -477,7 +522,8 @@ unsigned speedup_calculate_repetitions(
 void compensation_point_benchmark(
 		unsigned_huge num_processes,
 		unsigned_huge num_threads,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *));
 
 config_t comp_point_config;
@@ -494,37 +540,46 @@ void start_compensation_point_benchmark(char *option) {
 	_printf("###############\n");
 	comp_point_config = config;
 	void *(*loop_function_ptr)(void *) = &simple_integer_arithmetic_loop;
-	bool reduce = false;
+	reduce_strategy_t reduce = REDUCE_NONE;
+	schedule_t schedule = SCHEDULE_T_INIT;
 	print_table_set_additional_info("reduce option", "noreduce");
 
 	char *use_reduction = "reduce", *no_reduction = "noreduce";
 	char *loop_fn_int = "int", *loop_fn_float = "float";
+	char *loop_fn_linear = "linear", *loop_fn_random = "random";
 
 	// generate additional table columns
-	char *additional_info_header = "reduce option, loop function";
-	char *additional_info_reduce = "noreduce, ", *additional_info = NULL;
+	char *additional_info_header = "reduce option, loop function, schedule";
+	char *additional_info_reduce = "noreduce", *additional_info = NULL;
 
 	get_thread_array(config.threads->end);
 
 	if(option == NULL) option = "int";
 	get_token_t get_token_pointers = GET_TOKEN_T_INIT;
-	char *token;
-	while((token = get_token(&get_token_pointers, option, NULL)) != NULL) {
+	char *token, *token_option;
+	while((token = get_token(&get_token_pointers, option, &token_option)) != NULL) {
 		// process pthread / loop option
 		if(strcmp(token, use_reduction) == 0) {
-			reduce = true;
-			additional_info_reduce = "reduce, ";
+			reduce = reduce_strategy_parse(token_option);
+			if(reduce == REDUCE_NONE) {
+				_printf("WARNING: unknown reduction strategy: %s\n", token_option);
+			}
+			additional_info_reduce = reduce_strategy_names[reduce];
 			continue;
 		}
 		if(strcmp(token, no_reduction) == 0) {
-			reduce = false;
-			additional_info_reduce = "noreduce, ";
+			reduce = REDUCE_NONE;
+			additional_info_reduce = reduce_strategy_names[reduce];
+			continue;
+		}
+		if(schedule_parse(token, token_option, &schedule)) {
 			continue;
 		}
 
 		free(additional_info);
 		additional_info = NULL;
 		strappend(&additional_info, additional_info_reduce);
+		strappend(&additional_info, ", ");
 
 		if(strcmp(token, loop_fn_int) == 0) {
 			loop_function_ptr = &simple_integer_arithmetic_loop;
@@ -535,10 +590,20 @@ void start_compensation_point_benchmark(char *option) {
 			strappend(&additional_info, "float, ");
 
 		}
+		else if(strcmp(token, loop_fn_linear) == 0) {
+			loop_function_ptr = &linear_cost_loop;
+			strappend(&additional_info, "linear, ");
+		}
+		else if(strcmp(token, loop_fn_random) == 0) {
+			loop_function_ptr = &random_cost_loop;
+			strappend(&additional_info, "random, ");
+		}
 		else {
 			_printf("WARNING: unknown option for loop benchmark: %s\n", token);
 			continue;
 		}
+		schedule_append_name(&additional_info, schedule);
+		strappend(&additional_info, ", ");
 
 		print_table_set_additional_info(additional_info_header, additional_info);
 
@@ -573,7 +638,7 @@ void start_compensation_point_benchmark(char *option) {
 			unsigned_huge iterations; get_iteration_value("iteration", level, vec, &iterations);
 
 			compensation_point_benchmark(num_processes, num_threads,
-					reduce, loop_function_ptr);
+					reduce, schedule, loop_function_ptr);
 			return 0;
 		}
 
@@ -606,7 +671,8 @@ void start_compensation_point_benchmark(char *option) {
 void compensation_point_benchmark(
 		unsigned_huge num_processes,
 		unsigned_huge num_threads,
-		bool reduce,
+		reduce_strategy_t reduce,
+		schedule_t schedule,
 		void *(*loop_function_ptr)(void *)) {
 
 	unsigned_huge i;
@@ -661,10 +727,11 @@ void compensation_point_benchmark(
 			while(true) {
 				if(r>100) break;
 				r++;
-				serial_time_cache_t *cacheline = get_cache_line(&comp_cache_size, &comp_cache, iterations);
+				serial_time_cache_t *cacheline = get_cache_line(&comp_cache_size, &comp_cache,
+						iterations, loop_function_ptr);
 
 				speedup_benchmark(num_processes, num_threads,
-						iterations, reduce, loop_function_ptr, cacheline);
+						iterations, reduce, schedule, loop_function_ptr, cacheline);
 
 				double ratio = 1 / intern_speedup_stat.mean;
 #ifdef COMPILE_WITH_MPI
@@ -736,5 +803,7 @@ void compensation_point_benchmark(
 	print_table_cell("%{speedup}" PRECISSION "f,", speedup_mean_stat.mean);
 	print_table_cell("%{speedup mean dev}" PRECISSION "f, ", speedup_mean_stat.deviation);
 	print_table_cell("%{speedup dev mean}" PRECISSION "f, ", speedup_deviation_stat.mean);
+	print_table_cell("%{dispatch overhead}" PRECISSION "f, ",
+			num_threads > 1 ? threads_dispatch_overhead(num_threads) : 0.0);
 	print_table_line();
 }
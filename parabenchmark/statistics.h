@@ -46,6 +46,7 @@ statistic_t calculate_statistics(
 		int length);
 
 double median(double *array, int size);
+double percentile(double *array, int size, double p);
 statistic_t middle_stat(double *array, int size);
 
 typedef struct {
@@ -0,0 +1,348 @@
+/*
+ * sync_benchmark.c
+ *
+ * Latency of an empty parallel region for different synchronization
+ * mechanisms: the condition variable handshake of the worker pool,
+ * pthread barriers, futexes and spinning barriers.
+ *
+ * Copyright (C) 2012  Thomas Rebele (thomas.rebele at mytum dot de)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "definitions.h"
+#include "config.h"
+#include "sync_benchmark.h"
+#include "pthread_functions.h"
+#include "timer.h"
+#include "statistics.h"
+#include "print_functions.h"
+#include "parse.h"
+#include "nested_for.h"
+
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#define __USE_GNU
+#include <sched.h>
+#include <pthread.h>
+
+extern config_t config;
+
+/**
+ * distance of data written by different threads (avoids false sharing)
+ */
+#define SYNC_PADDING 128
+
+/**
+ * spinning threads yield the processor after this many polls, so that
+ * oversubscribed runs still make progress
+ */
+#define SYNC_SPIN_YIELD 1024
+
+typedef enum {
+	SYNC_CONDVAR,		// start/end handshake of the worker pool (see config.thread_dispatch)
+	SYNC_PTHREAD_BARRIER,
+	SYNC_FUTEX,			// counter and generation, futex wait/wake
+	SYNC_SPIN,			// centralized sense reversing spin barrier
+	SYNC_DISSEMINATION,	// dissemination barrier, log2(n) rounds of flags
+	SYNC_MECHANISM_COUNT
+} sync_mechanism_t;
+
+char *sync_mechanism_names[] = {"condvar", "pthread-barrier", "futex", "spin", "dissemination"};
+
+#define SYNC_MAX_ROUNDS 32
+
+/**
+ * flags of one thread for the dissemination barrier
+ */
+typedef struct {
+	volatile int flag[2][SYNC_MAX_ROUNDS];
+} __attribute__((aligned(SYNC_PADDING))) sync_flags_t;
+
+typedef struct {
+	unsigned num_threads;
+	unsigned_huge steps;
+	sync_mechanism_t mechanism;
+
+	pthread_barrier_t pthread_barrier;
+
+	// futex and spin barrier
+	volatile int count __attribute__((aligned(SYNC_PADDING)));
+	volatile int generation __attribute__((aligned(SYNC_PADDING)));
+
+	// dissemination barrier
+	sync_flags_t *flags;
+	unsigned rounds;
+} sync_shared_t;
+
+/**
+ * state of one thread, which persists over the barrier episodes
+ */
+typedef struct {
+	sync_shared_t *shared;
+	int sense;
+	int parity;
+} sync_thread_data_t;
+
+static inline void sync_pause(unsigned *spins) {
+	if(++*spins % SYNC_SPIN_YIELD == 0) sched_yield();
+	else __asm__ __volatile__ ("pause" ::: "memory");
+}
+
+void sync_futex_barrier(sync_thread_data_t *data) {
+	sync_shared_t *shared = data->shared;
+	int generation = shared->generation;
+	if(__sync_add_and_fetch(&shared->count, 1) == shared->num_threads) {
+		shared->count = 0;
+		__sync_add_and_fetch(&shared->generation, 1);
+		syscall(SYS_futex, &shared->generation, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+	}
+	else {
+		while(shared->generation == generation) {
+			syscall(SYS_futex, &shared->generation, FUTEX_WAIT_PRIVATE, generation, NULL, NULL, 0);
+		}
+	}
+}
+
+void sync_spin_barrier(sync_thread_data_t *data) {
+	sync_shared_t *shared = data->shared;
+	data->sense = !data->sense;
+	if(__sync_sub_and_fetch(&shared->count, 1) == 0) {
+		shared->count = shared->num_threads;
+		__sync_synchronize();
+		shared->generation = data->sense;
+	}
+	else {
+		unsigned spins = 0;
+		while(shared->generation != data->sense) sync_pause(&spins);
+	}
+}
+
+void sync_dissemination_barrier(sync_thread_data_t *data, unsigned tid) {
+	sync_shared_t *shared = data->shared;
+	unsigned round, distance = 1;
+	for(round=0; round<shared->rounds; round++, distance*=2) {
+		unsigned partner = (tid + distance) % shared->num_threads;
+		shared->flags[partner].flag[data->parity][round] = data->sense;
+		unsigned spins = 0;
+		while(shared->flags[tid].flag[data->parity][round] != data->sense) sync_pause(&spins);
+	}
+	if(data->parity == 1) data->sense = !data->sense;
+	data->parity = 1 - data->parity;
+}
+
+static inline void sync_barrier(sync_thread_data_t *data, unsigned tid) {
+	switch(data->shared->mechanism) {
+	case SYNC_PTHREAD_BARRIER: pthread_barrier_wait(&data->shared->pthread_barrier); break;
+	case SYNC_FUTEX: sync_futex_barrier(data); break;
+	case SYNC_SPIN: sync_spin_barrier(data); break;
+	case SYNC_DISSEMINATION: sync_dissemination_barrier(data, tid); break;
+	default: break;
+	}
+}
+
+/**
+ * One barrier to line up the threads, then 'steps' barriers, which
+ * enclose empty parallel regions. Every thread measures its own time
+ */
+void *sync_barrier_loop(void *arg_ptr) {
+	thread_arg_t *arg = (thread_arg_t*) arg_ptr;
+	sync_thread_data_t *data = (sync_thread_data_t*) arg->data;
+	unsigned tid = arg->tid;
+	unsigned_huge i, steps = data->shared->steps;
+	sync_barrier(data, tid);
+	double tmp;
+	tick2(MODE_START, &tmp);
+	for(i=0; i<steps; i++) {
+		sync_barrier(data, tid);
+	}
+	arg->time = tick2(MODE_END, &tmp);
+	return (void *)NULL;
+}
+
+void *sync_empty_loop(void *arg_ptr) {
+	return (void *)NULL;
+}
+
+/**
+ * time of 'steps' fork/joins of an empty loop function through the worker
+ * pool, measured as in pthread_loop_test() (start and join, not prepare)
+ */
+double sync_condvar_test(thread_arg_t *args, unsigned num_threads, unsigned_huge steps) {
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &sync_empty_loop;
+	}
+	double time = 0;
+	unsigned_huge step;
+	for(step=0; step<steps; step++) {
+		threads_prepare(args, num_threads);
+		tick(MODE_START);
+		threads_start(args, num_threads);
+		threads_join(args, num_threads);
+		time += tick(MODE_END);
+	}
+	return time;
+}
+
+/**
+ * time of 'steps' barriers, taken from the slowest thread
+ */
+double sync_barrier_test(thread_arg_t *args, unsigned num_threads, sync_thread_data_t *data) {
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		args[i].reduce = false;
+		args[i].thread_count = num_threads;
+		args[i].loop_function = &sync_barrier_loop;
+		args[i].data = &data[i];
+	}
+	threads_prepare(args, num_threads);
+	threads_start(args, num_threads);
+	threads_join(args, num_threads);
+	double max = 0;
+	for(i=0; i<num_threads; i++) {
+		max = args[i].time > max ? args[i].time : max;
+	}
+	return max;
+}
+
+void sync_test(unsigned num_threads, sync_mechanism_t mechanism) {
+	if(num_threads == 0) return;
+	thread_arg_t *args = get_thread_array(num_threads);
+	if(args == NULL) {
+		_printf("Cannot allocate enough space for threads\n");
+		return;
+	}
+	unsigned_huge steps = config.steps.number;
+	unsigned_huge repetitions = config.repetitions.number;
+
+	sync_shared_t *shared = NULL;
+	if(posix_memalign((void **)&shared, SYNC_PADDING, sizeof(sync_shared_t)) != 0) {
+		_printf("WARNING: couldn't allocate barrier for sync benchmark\n");
+		return;
+	}
+	memset(shared, 0, sizeof(sync_shared_t));
+	shared->num_threads = num_threads;
+	shared->steps = steps;
+	shared->mechanism = mechanism;
+	shared->count = mechanism == SYNC_SPIN ? num_threads : 0;
+	pthread_barrier_init(&shared->pthread_barrier, NULL, num_threads);
+	for(shared->rounds=0; (1u << shared->rounds) < num_threads; shared->rounds++);
+	if(posix_memalign((void **)&shared->flags, SYNC_PADDING, num_threads * sizeof(sync_flags_t)) != 0) {
+		_printf("WARNING: couldn't allocate barrier for sync benchmark\n");
+		free(shared);
+		return;
+	}
+	memset(shared->flags, 0, num_threads * sizeof(sync_flags_t));
+
+	sync_thread_data_t data[num_threads];
+	unsigned i;
+	for(i=0; i<num_threads; i++) {
+		data[i].shared = shared;
+		data[i].sense = 1;
+		data[i].parity = 0;
+	}
+	// the spin barrier flips the sense before waiting
+	if(mechanism == SYNC_SPIN) {
+		for(i=0; i<num_threads; i++) data[i].sense = 0;
+	}
+
+	double *time_single = (double*)malloc((repetitions+1)*sizeof(double));
+	int r;
+	for(r=-config.warmup; r<(int)repetitions; r++) {
+		double time = mechanism == SYNC_CONDVAR
+				? sync_condvar_test(args, num_threads, steps)
+				: sync_barrier_test(args, num_threads, data);
+		if(r >= 0) time_single[r] = time / steps;
+	}
+	statistic_t stat = middle_stat(time_single, repetitions);
+	free(time_single);
+	pthread_barrier_destroy(&shared->pthread_barrier);
+	free(shared->flags);
+	free(shared);
+
+	print_table_cell("%{threads}5u, ", num_threads);
+	print_table_cell("%{steps}9Lu, ", steps);
+	print_table_cell("%{repetitions}6Lu, ", repetitions);
+	print_table_cell("%{ns per barrier}" PRECISSION "f, ", stat.mean * 1e9);
+	print_table_cell("%{deviation ns}" PRECISSION "f, ", stat.deviation * 1e9);
+	print_table_line();
+}
+
+void start_sync_benchmark(char *option) {
+	_printf("\n### RESULTS ###\n");
+	_printf("sync benchmark\n");
+	_printf("time of one empty parallel region (one barrier, or one fork/join of the worker pool for condvar)\n");
+	_printf("worker pool dispatch: %s\n", config.thread_dispatch == DISPATCH_SPIN ? "spin" : "condvar");
+	_printf("steps: barriers per repetition, barrier time is taken from the slowest thread\n");
+	_printf("spinning threads yield after %d polls\n", SYNC_SPIN_YIELD);
+	_printf("###############\n");
+
+	if(option == NULL || strcmp(option, "all") == 0) option = "condvar,pthread-barrier,futex,spin,dissemination";
+
+	get_thread_array(config.threads->end);
+
+	unsigned option_count;
+	char **options = get_token_array(option, &option_count);
+	sync_mechanism_t mechanism = SYNC_CONDVAR;
+
+	int set_mechanism_fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_option;
+		get_iteration_value("option", level, vec, &num_option);
+		if(num_option >= option_count) return NESTED_FOR_BREAK;
+		for(mechanism=0; mechanism<SYNC_MECHANISM_COUNT; mechanism++) {
+			if(strcmp(options[num_option], sync_mechanism_names[mechanism]) == 0) break;
+		}
+		if(mechanism == SYNC_MECHANISM_COUNT) {
+			_printf("WARNING: unknown option for sync benchmark: %s\n", options[num_option]);
+			return NESTED_FOR_CONT;
+		}
+		// the fork/join uses the dispatch of the worker pool, name the one measured
+		char *mechanism_name = sync_mechanism_names[mechanism];
+		if(mechanism == SYNC_CONDVAR && config.thread_dispatch == DISPATCH_SPIN) {
+			mechanism_name = "pool-spin";
+		}
+		print_table_set_additional_info("mechanism", mechanism_name);
+		print_header();
+		return 0;
+	}
+
+	int fn(unsigned level, iteration_var_t *vec) {
+		unsigned_huge num_threads; get_iteration_value("thread", level, vec, &num_threads);
+		sync_test(num_threads, mechanism);
+		return 0;
+	}
+
+	// loop configuration
+	for_loop_t option_loop = FOR_LOOP_T_INIT;
+	option_loop.var.name = "option";
+	option_loop.var.start = 0;
+	option_loop.var.end = option_count;
+	option_loop.step_fn = &step_increment;
+	option_loop.inner_start_fn = &set_mechanism_fn;
+
+	for_loop_t thread_loop = FOR_LOOP_T_INIT;
+	thread_loop.var.name = "thread";
+	thread_loop.var.range = config.threads;
+	thread_loop.step_fn = &step_range;
+
+	option_loop.next = &thread_loop;
+
+	nested_for_loop(&option_loop, fn);
+}
@@ -25,6 +25,7 @@
 #include "git_ref.h"
 #include "range.h"
 #include "parse.h"
+#include "memory_functions.h"
 #include <stdio.h>
 #include <sys/sysinfo.h>
 #ifdef COMPILE_WITH_MPI
@@ -53,6 +54,12 @@ int hostname_size = 0;
 
 char **cpuworld;
 
+numa_node_t *numa_nodes = NULL;
+int numa_nodes_size = 0;
+
+cache_info_t *caches = NULL;
+int caches_size = 0;
+
 /**
  * parse information of CPU frequency
  */
@@ -90,6 +97,188 @@ sys_cpu_t fetch_sys_cpu_info(int processorid) {
 	return result;
 }
 
+/**
+ * read first line of a file in /sys. Returns NULL if it doesn't exist
+ */
+char *read_sys_file(char *filename, char *buffer, int size) {
+	FILE *fh = fopen(filename, "r");
+	if(fh == NULL) return NULL;
+	char *result = fgets(buffer, size-1, fh);
+	fclose(fh);
+	if(result != NULL) right_trim(result);
+	return result;
+}
+
+/**
+ * parse a list like "0-3,8,10-11" (format of /sys/devices/system).
+ * Returns the number of elements, which are stored in *values
+ */
+int parse_sys_list(char *str, unsigned **values) {
+	int size = 0;
+	*values = NULL;
+	while(*str != 0) {
+		char *end;
+		unsigned from = strtoul(str, &end, 10);
+		if(end == str) break;
+		unsigned to = from;
+		str = end;
+		if(*str == '-') {
+			to = strtoul(str+1, &end, 10);
+			str = end;
+		}
+		*values = (unsigned*)realloc(*values, (size + to - from + 1)*sizeof(unsigned));
+		unsigned i;
+		for(i=from; i<=to; i++) {
+			(*values)[size++] = i;
+		}
+		if(*str == ',') str++;
+	}
+	return size;
+}
+
+/**
+ * parse NUMA topology of /sys/devices/system/node. Without NUMA support
+ * all processors are assigned to node 0
+ */
+void fetch_numa_info() {
+	if(numa_nodes_size != 0) return;
+
+	char buffer[4096];
+	unsigned *node_ids;
+	int node_size = 0;
+	if(read_sys_file("/sys/devices/system/node/online", buffer, sizeof(buffer)) != NULL) {
+		node_size = parse_sys_list(buffer, &node_ids);
+	}
+	if(node_size == 0) {
+		fetch_cpu_info();
+		numa_nodes = (numa_node_t*)calloc(1, sizeof(numa_node_t));
+		numa_nodes[0].cpulist = "all";
+		numa_nodes[0].cpus = (unsigned*)calloc(cpuinfos_size, sizeof(unsigned));
+		int i;
+		for(i=0; i<cpuinfos_size; i++) {
+			numa_nodes[0].cpus[i] = cpuinfos[i].processor_id;
+		}
+		numa_nodes[0].cpu_size = cpuinfos_size;
+		struct sysinfo info;
+		if(sysinfo(&info) == 0) {
+			numa_nodes[0].mem_total = (unsigned_huge)info.totalram * info.mem_unit;
+		}
+		numa_nodes_size = 1;
+		return;
+	}
+
+	numa_nodes = (numa_node_t*)calloc(node_size, sizeof(numa_node_t));
+	int i;
+	for(i=0; i<node_size; i++) {
+		numa_node_t *node = &numa_nodes[i];
+		char filename[1024];
+		node->node_id = node_ids[i];
+
+		sprintf(filename, "/sys/devices/system/node/node%d/cpulist", node->node_id);
+		if(read_sys_file(filename, buffer, sizeof(buffer)) == NULL) buffer[0] = 0;
+		node->cpulist = (char*)calloc(strlen(buffer)+1, sizeof(char));
+		strcpy(node->cpulist, buffer);
+		node->cpu_size = parse_sys_list(buffer, &node->cpus);
+
+		sprintf(filename, "/sys/devices/system/node/node%d/meminfo", node->node_id);
+		FILE *fh = fopen(filename, "r");
+		if(fh == NULL) continue;
+		while(fgets(buffer, sizeof(buffer)-1, fh) != NULL) {
+			char *key = strstr(buffer, "MemTotal:");
+			if(key != NULL) {
+				node->mem_total = strtoull(key + strlen("MemTotal:"), NULL, 10) * 1024;
+				break;
+			}
+		}
+		fclose(fh);
+	}
+	free(node_ids);
+	numa_nodes_size = node_size;
+}
+
+unsigned get_numa_node_count() {
+	fetch_numa_info();
+	return numa_nodes_size;
+}
+
+numa_node_t *get_numa_node(unsigned i) {
+	fetch_numa_info();
+	if(i >= numa_nodes_size) return NULL;
+	return &numa_nodes[i];
+}
+
+int get_numa_node_of_cpu(unsigned processorid) {
+	fetch_numa_info();
+	int i, j;
+	for(i=0; i<numa_nodes_size; i++) {
+		for(j=0; j<numa_nodes[i].cpu_size; j++) {
+			if(numa_nodes[i].cpus[j] == processorid) return numa_nodes[i].node_id;
+		}
+	}
+	return -1;
+}
+
+/**
+ * parse cache information of the first processor
+ * (/sys/devices/system/cpu/cpu0/cache/index*)
+ */
+void fetch_cache_info() {
+	if(caches_size != 0) return;
+
+	char buffer[1024];
+	char filename[1024];
+	int index;
+	for(index=0; ; index++) {
+		sprintf(filename, "/sys/devices/system/cpu/cpu0/cache/index%d/level", index);
+		if(read_sys_file(filename, buffer, sizeof(buffer)) == NULL) break;
+
+		caches = (cache_info_t*)realloc(caches, (index+1)*sizeof(cache_info_t));
+		cache_info_t *cache = &caches[index];
+		cache->level = atoi(buffer);
+
+		typedef struct tmp { char *name; char **var; } tmp_t;
+		tmp_t keys[] = {
+				{"type", &cache->type},
+				{"shared_cpu_list", &cache->shared_cpu_list},
+				{NULL, NULL}};
+		tmp_t *act_key = keys;
+		while(act_key->name != NULL) {
+			sprintf(filename, "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, act_key->name);
+			if(read_sys_file(filename, buffer, sizeof(buffer)) == NULL) buffer[0] = 0;
+			*(act_key->var) = (char*)calloc(strlen(buffer)+1, sizeof(char));
+			strcpy(*(act_key->var), buffer);
+			act_key++;
+		}
+
+		// size is given like "48K"
+		sprintf(filename, "/sys/devices/system/cpu/cpu0/cache/index%d/size", index);
+		cache->size = 0;
+		if(read_sys_file(filename, buffer, sizeof(buffer)) != NULL) {
+			char *unit;
+			cache->size = strtoull(buffer, &unit, 10);
+			if(*unit == 'K') cache->size *= KB;
+			if(*unit == 'M') cache->size *= MB;
+			if(*unit == 'G') cache->size *= GB;
+		}
+		sprintf(filename, "/sys/devices/system/cpu/cpu0/cache/index%d/coherency_line_size", index);
+		cache->line_size = read_sys_file(filename, buffer, sizeof(buffer)) ? atoi(buffer) : 0;
+		sprintf(filename, "/sys/devices/system/cpu/cpu0/cache/index%d/ways_of_associativity", index);
+		cache->ways = read_sys_file(filename, buffer, sizeof(buffer)) ? atoi(buffer) : 0;
+	}
+	caches_size = index;
+}
+
+unsigned get_cache_count() {
+	fetch_cache_info();
+	return caches_size;
+}
+
+cache_info_t *get_cache_info(unsigned i) {
+	fetch_cache_info();
+	if(i >= caches_size) return NULL;
+	return &caches[i];
+}
+
 /**
  * parse information of /proc/cpuinfo and save it to arrays cpuinfos and processors
  */
@@ -271,6 +460,23 @@ void print_config_info() {
 	case AFFINITY_ROUND_ROBIN: _printf("roundrobin"); break;
 	}
 	_printf(";\n");
+	_printf("\tthread dispatch=");
+	switch (config.thread_dispatch) {
+	case DISPATCH_CONDVAR: _printf("condvar"); break;
+	case DISPATCH_SPIN: _printf("spin %.1f us", config.dispatch_spin_time * 1e6); break;
+	}
+	_printf(";\n");
+	_printf("\tmemory allocation=%s;\n", memory_alloc_name(config.memory.alloc));
+	_printf("\tmemory cache state=%s;\n", memory_cache_state_name(config.memory.cache_state));
+	_printf("\tmemory numa placement=%s", memory_numa_name(config.memory.numa));
+	if(config.memory.numa == NUMA_BIND) _printf(" node %d", config.memory.numa_node);
+	_printf(";\n");
+	_printf("\tio file=%s, size=%Lu;\n", config.io.file, config.io.file_size);
+	_printf("\tio blocksize:\n"); range_print("\t\t", config.io.blocksize);
+	_printf("\tio queue depth:\n"); range_print("\t\t", config.io.queue_depth);
+	_printf("\tlock critical section:\n"); range_print("\t\t", config.lock.critical_section);
+	_printf("\tlock think time:\n"); range_print("\t\t", config.lock.think_time);
+	_printf("\tlock read ratio:\n"); range_print("\t\t", config.lock.read_ratio);
 
 	_printf("\trepetitions time guide value=%15.11f, ", config.repetitions.time_guide_value);
 	_printf("number value=%d, ", config.repetitions.number);
@@ -370,6 +576,33 @@ void print_mem_info() {
 
 }
 
+/**
+ * print NUMA nodes with their processors and memory
+ */
+void print_numa_info() {
+	_printf("numa info:\n");
+	fetch_numa_info();
+	int i;
+	for(i=0; i<numa_nodes_size; i++) {
+		_printf("\tnode%d: cpus=%s (%d), memory total=%Lu;\n", numa_nodes[i].node_id,
+				numa_nodes[i].cpulist, numa_nodes[i].cpu_size, numa_nodes[i].mem_total);
+	}
+}
+
+/**
+ * print caches of the first processor
+ */
+void print_cache_info() {
+	_printf("cache info (cpu0):\n");
+	fetch_cache_info();
+	int i;
+	for(i=0; i<caches_size; i++) {
+		_printf("\tL%d %s: size=%Lu, line size=%u, ways=%u, shared with cpus=%s;\n",
+				caches[i].level, caches[i].type, caches[i].size, caches[i].line_size,
+				caches[i].ways, caches[i].shared_cpu_list);
+	}
+}
+
 /**
  * print actually 5 topmost cpu and memory consuming processes
  */
@@ -443,6 +676,8 @@ void print_system_info() {
 	print_thread_affinity();
 #endif
 	print_mem_info();
+	print_numa_info();
+	print_cache_info();
 
 	print_top_info();
 
@@ -517,6 +752,9 @@ void print_mpi_info() {
 
 #define max(a,b) ((a) < (b) ? (b) : (a))
 float get_cpu_frequency(int processorid) {
+	if(cpuinfos_size == 0) {
+		fetch_cpu_info();
+	}
 	if(processorid >= cpuinfos_size) return NAN;
 	float result = 0;
 	processorid = -1; // not providing frequency per processor
@@ -535,6 +773,14 @@ unsigned get_cpu_count() {
 	return cpuinfos_size;
 }
 
+/**
+ * information of the i-th processor of /proc/cpuinfo
+ */
+cpuinfo_t *get_cpuinfo(unsigned i) {
+	if(i >= get_cpu_count()) return NULL;
+	return &cpuinfos[i];
+}
+
 unsigned get_processorid_recommendation(unsigned i) {
 	int rest = i+1;
 #ifdef COMPILE_WITH_MPI
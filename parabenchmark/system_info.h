@@ -62,17 +62,46 @@ typedef struct {
 	unsigned mem_free;
 } meminfo_t;
 
+typedef struct {
+	int node_id;
+	char *cpulist;
+	unsigned *cpus;
+	int cpu_size;
+	unsigned_huge mem_total;
+} numa_node_t;
+
+typedef struct {
+	int level;
+	char *type;
+	unsigned_huge size;
+	unsigned line_size;
+	unsigned ways;
+	char *shared_cpu_list;
+} cache_info_t;
+
 char* get_hostname();
 unsigned get_cpu_count();
+cpuinfo_t *get_cpuinfo(unsigned i);
 unsigned get_processorid_recommendation(unsigned i);
 float get_cpu_frequency(int);
 
+void fetch_numa_info();
+unsigned get_numa_node_count();
+numa_node_t *get_numa_node(unsigned i);
+int get_numa_node_of_cpu(unsigned processorid);
+
+void fetch_cache_info();
+unsigned get_cache_count();
+cache_info_t *get_cache_info(unsigned i);
+
 void fetch_cpu_info();
 void print_system_info();
 void print_cpu_info();
 void print_mpi_info();
 void print_top_info();
 void print_config_info();
+void print_numa_info();
+void print_cache_info();
 
 
 #endif
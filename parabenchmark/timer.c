@@ -111,6 +111,29 @@ double tick(byte modus){
 	return 0;
 }
 
+/**
+ * like tick, but the start time is kept per thread. Used by the memory
+ * kernels, which measure their time on the worker threads
+ */
+__thread timespec_t thread_last_time;
+double tick_thread(byte modus){
+	if(modus == MODE_START){
+		clock_gettime(CLOCK_REALTIME , &thread_last_time);
+	}
+	else if(modus == MODE_END){
+		timespec_t act_time;
+		clock_gettime(CLOCK_REALTIME , &act_time);
+		timespec_t d = timespec_diff(thread_last_time, act_time);
+		double time = (double) d.tv_sec
+			+ (double) d.tv_nsec / (double) 1000000000;
+		if(isnan(calibration_tick_stat.mean))
+			return time;
+		else
+			return time - calibration_tick_stat.mean;
+	}
+	return 0;
+}
+
 /**
  * allows more than one time measurement at the same time
  */
@@ -132,6 +155,24 @@ double tick2(byte modus, double *tmp){
 	return 0;
 }
 
+/**
+ * like tick2, but keeps the start time as timespec, so that short
+ * intervals (single operations) are not rounded to the precision of a
+ * double holding the seconds since the epoch
+ */
+double tick_precise(byte modus, timespec_t *tmp){
+	if(modus == MODE_START){
+		clock_gettime(CLOCK_MONOTONIC, tmp);
+	}
+	else if(modus == MODE_END){
+		timespec_t now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timespec_t d = timespec_diff(*tmp, now);
+		return (double) d.tv_sec + (double) d.tv_nsec / (double) 1000000000;
+	}
+	return 0;
+}
+
 /**
  * calibrate timer (the time needed for the tick start and end call is measured and subtracted)
  */
@@ -34,7 +34,9 @@ void calibrate_context_switch_stat();
 unsigned context_switch_count();
 
 double tick(byte modus);
+double tick_thread(byte modus);
 double tick2(byte modus, double *tmp);
+double tick_precise(byte modus, timespec_t *tmp);
 #ifdef COMPILE_WITH_MPI
 #include <mpi.h>
 double tick_mpi(byte modus, MPI_Comm barrier);